@@ -0,0 +1,276 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск маршрута по запросу (A*): вершины просматриваются в порядке веса от начала
+// плюс нижней оценки веса до цели. Оценка - максимум из переданной оценки lower_bound
+// и оценок по ориентирам (ALT): для ориентира L вес маршрута v -> t не меньше
+// d(L, t) - d(L, v) и d(v, L) - d(t, L). Веса до ориентиров и от них рассчитываются
+// при создании маршрутизатора. Обе оценки должны быть согласованными
+// (h(u) <= w(u, v) + h(v)), тогда найденный маршрут кратчайший.
+template <typename Weight>
+class AStarRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+    using LowerBound = std::function<Weight(VertexId from, VertexId to)>;
+
+    explicit AStarRouter(const Graph& graph, LowerBound lower_bound = {}, size_t landmark_count = 0);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    const std::vector<VertexId>& GetLandmarks() const {
+        return landmarks_;
+    }
+
+private:
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                              ? std::numeric_limits<Weight>::infinity()
+                                              : std::numeric_limits<Weight>::max();
+
+    // Рабочие массивы поиска; в куче хранится вес от начала плюс оценка до цели
+    struct SearchData {
+        using HeapItem = std::pair<Weight, VertexId>;
+
+        void Prepare(size_t vertex_count) {
+            if (marks.size() < vertex_count) {
+                weights.resize(vertex_count);
+                estimates.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+                marks.resize(vertex_count, 0);
+            }
+            heap.clear();
+            if (++current_mark == 0) {
+                std::fill(marks.begin(), marks.end(), 0);
+                current_mark = 1;
+            }
+        }
+
+        std::vector<Weight> weights;
+        std::vector<Weight> estimates;
+        std::vector<std::optional<EdgeId>> prev_edges;
+        std::vector<uint32_t> marks;
+        std::vector<HeapItem> heap;
+        uint32_t current_mark = 0;
+    };
+
+    void BuildLandmarks(size_t landmark_count);
+
+    // веса маршрутов из source во все вершины по дугам incidence
+    std::vector<Weight> ComputeWeights(const FrozenIncidence<Weight>& incidence, VertexId source) const;
+
+    Weight EstimateWeight(VertexId from, VertexId to) const;
+
+    const Graph& graph_;
+    const FrozenIncidence<Weight>& incidence_;
+    LowerBound lower_bound_;
+    std::vector<VertexId> landmarks_;
+    std::vector<Weight> from_landmarks_;                        // d(L, v) в ячейке v * K + L
+    std::vector<Weight> to_landmarks_;                          // d(v, L) в ячейке v * K + L
+};
+
+template <typename Weight>
+AStarRouter<Weight>::AStarRouter(const Graph& graph, LowerBound lower_bound, size_t landmark_count)
+    : graph_(graph)
+    , incidence_(graph.GetFrozenIncidence())
+    , lower_bound_(std::move(lower_bound))
+{
+    for (const Weight weight : incidence_.weights) {
+        if (weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    BuildLandmarks(std::min(landmark_count, graph.GetVertexCount()));
+}
+
+template <typename Weight>
+std::vector<Weight> AStarRouter<Weight>::ComputeWeights(const FrozenIncidence<Weight>& incidence, VertexId source) const {
+    using HeapItem = std::pair<Weight, VertexId>;
+    std::vector<Weight> weights(graph_.GetVertexCount(), INFINITE_WEIGHT);
+    std::vector<HeapItem> heap;
+    weights[source] = ZERO_WEIGHT;
+    heap.emplace_back(ZERO_WEIGHT, source);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+        const auto [weight, vertex] = heap.back();
+        heap.pop_back();
+        if (weights[vertex] < weight) {
+            continue;
+        }
+        for (size_t arc = incidence.offsets[vertex]; arc < incidence.offsets[vertex + 1]; ++arc) {
+            const VertexId next = incidence.targets[arc];
+            const Weight candidate_weight = weight + incidence.weights[arc];
+            if (candidate_weight < weights[next]) {
+                weights[next] = candidate_weight;
+                heap.emplace_back(candidate_weight, next);
+                std::push_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+            }
+        }
+    }
+    return weights;
+}
+
+template <typename Weight>
+void AStarRouter<Weight>::BuildLandmarks(size_t landmark_count) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (landmark_count == 0) {
+        return;
+    }
+
+    // дуги в обратную сторону, чтобы считать веса маршрутов до ориентира
+    FrozenIncidence<Weight> reversed;
+    reversed.offsets.assign(vertex_count + 1, 0);
+    for (const VertexId target : incidence_.targets) {
+        ++reversed.offsets[target + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        reversed.offsets[vertex + 1] += reversed.offsets[vertex];
+    }
+    reversed.targets.resize(incidence_.targets.size());
+    reversed.weights.resize(incidence_.weights.size());
+    reversed.edge_ids.resize(incidence_.edge_ids.size());
+    std::vector<size_t> positions(reversed.offsets.begin(), reversed.offsets.end() - 1);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t arc = incidence_.offsets[vertex]; arc < incidence_.offsets[vertex + 1]; ++arc) {
+            const size_t position = positions[incidence_.targets[arc]]++;
+            reversed.targets[position] = vertex;
+            reversed.weights[position] = incidence_.weights[arc];
+            reversed.edge_ids[position] = incidence_.edge_ids[arc];
+        }
+    }
+
+    // ориентиры выбираются по очереди как самые далекие от уже выбранных (недостижимые
+    // из них - дальше всех): так они оказываются на окраинах сети, где оценки точнее.
+    // Вершины без исходящих дуг ориентирами не становятся
+    std::vector<std::vector<Weight>> from_weights;
+    std::vector<std::vector<Weight>> to_weights;
+    std::vector<Weight> nearest(vertex_count, INFINITE_WEIGHT);
+    for (size_t i = 0; i < landmark_count; ++i) {
+        std::optional<VertexId> farthest;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (incidence_.offsets[vertex] == incidence_.offsets[vertex + 1] || nearest[vertex] == ZERO_WEIGHT) {
+                continue;
+            }
+            if (!farthest || nearest[*farthest] < nearest[vertex]) {
+                farthest = vertex;
+            }
+        }
+        if (!farthest) {
+            break;
+        }
+        landmarks_.push_back(*farthest);
+        from_weights.push_back(ComputeWeights(incidence_, *farthest));
+        to_weights.push_back(ComputeWeights(reversed, *farthest));
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            nearest[vertex] = std::min(nearest[vertex], from_weights.back()[vertex]);
+        }
+    }
+
+    const size_t count = landmarks_.size();
+    from_landmarks_.resize(vertex_count * count);
+    to_landmarks_.resize(vertex_count * count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t i = 0; i < count; ++i) {
+            from_landmarks_[vertex * count + i] = from_weights[i][vertex];
+            to_landmarks_[vertex * count + i] = to_weights[i][vertex];
+        }
+    }
+}
+
+template <typename Weight>
+Weight AStarRouter<Weight>::EstimateWeight(VertexId from, VertexId to) const {
+    Weight estimate = lower_bound_ ? lower_bound_(from, to) : ZERO_WEIGHT;
+    const size_t count = landmarks_.size();
+    const Weight* from_landmarks_from = from_landmarks_.data() + from * count;
+    const Weight* from_landmarks_to = from_landmarks_.data() + to * count;
+    const Weight* to_landmarks_from = to_landmarks_.data() + from * count;
+    const Weight* to_landmarks_to = to_landmarks_.data() + to * count;
+    for (size_t i = 0; i < count; ++i) {
+        // недостижимые ориентиры ничего не говорят о весе маршрута
+        if (from_landmarks_to[i] != INFINITE_WEIGHT && from_landmarks_from[i] != INFINITE_WEIGHT
+            && from_landmarks_from[i] < from_landmarks_to[i]) {
+            estimate = std::max(estimate, from_landmarks_to[i] - from_landmarks_from[i]);
+        }
+        if (to_landmarks_from[i] != INFINITE_WEIGHT && to_landmarks_to[i] != INFINITE_WEIGHT
+            && to_landmarks_to[i] < to_landmarks_from[i]) {
+            estimate = std::max(estimate, to_landmarks_from[i] - to_landmarks_to[i]);
+        }
+    }
+    return estimate;
+}
+
+template <typename Weight>
+std::optional<typename AStarRouter<Weight>::RouteInfo> AStarRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    using HeapItem = typename SearchData::HeapItem;
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    static thread_local SearchData data;
+    data.Prepare(vertex_count);
+    const auto reach = [this, to](VertexId vertex, Weight weight, std::optional<EdgeId> prev_edge) {
+        if (data.marks[vertex] != data.current_mark) {
+            data.marks[vertex] = data.current_mark;
+            data.estimates[vertex] = EstimateWeight(vertex, to);
+        }
+        data.weights[vertex] = weight;
+        data.prev_edges[vertex] = prev_edge;
+        data.heap.emplace_back(weight + data.estimates[vertex], vertex);
+        std::push_heap(data.heap.begin(), data.heap.end(), std::greater<HeapItem>{});
+    };
+    reach(from, ZERO_WEIGHT, std::nullopt);
+
+    bool is_found = false;
+    while (!data.heap.empty()) {
+        std::pop_heap(data.heap.begin(), data.heap.end(), std::greater<HeapItem>{});
+        const auto [priority, vertex] = data.heap.back();
+        data.heap.pop_back();
+        if (data.weights[vertex] + data.estimates[vertex] < priority) {
+            continue;
+        }
+        if (vertex == to) {
+            is_found = true;
+            break;
+        }
+        const Weight weight = data.weights[vertex];
+        for (size_t arc = incidence_.offsets[vertex]; arc < incidence_.offsets[vertex + 1]; ++arc) {
+            const VertexId next = incidence_.targets[arc];
+            const Weight candidate_weight = weight + incidence_.weights[arc];
+            if (data.marks[next] != data.current_mark || candidate_weight < data.weights[next]) {
+                reach(next, candidate_weight, incidence_.edge_ids[arc]);
+            }
+        }
+    }
+    if (!is_found) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = data.prev_edges[to];
+         edge_id;
+         edge_id = data.prev_edges[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{data.weights[to], std::move(edges)};
+}
+
+}  // namespace graph
@@ -0,0 +1,490 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+template <typename Weight>
+class ContractionHierarchyRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    static constexpr EdgeId NO_ARC = std::numeric_limits<EdgeId>::max();
+
+    // Дуга иерархии: исходное ребро графа (номер дуги совпадает с номером ребра)
+    // или сокращение, заменяющее пару дуг first_child + second_child
+    struct Arc {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first_child = NO_ARC;
+        EdgeId second_child = NO_ARC;
+    };
+
+    explicit ContractionHierarchyRouter(const Graph& graph);
+
+    // Иерархия, построенная ранее для того же графа: сокращения - дуги после исходных ребер
+    // из GetArcs, списки дуг вверх - из GetForwardArcIds и GetBackwardArcIds. Сокращения
+    // проверяются, и при несогласованности с графом выбрасывается std::invalid_argument
+    ContractionHierarchyRouter(const Graph& graph, std::vector<Arc> shortcuts,
+                               const std::vector<EdgeId>& forward_arc_ids, const std::vector<EdgeId>& backward_arc_ids);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    size_t GetShortcutCount() const {
+        return arcs_.size() - graph_.GetEdgeCount();
+    }
+
+    const std::vector<Arc>& GetArcs() const {
+        return arcs_;
+    }
+    // дуги вверх по вершинам: из вершины from и в вершину to соответственно
+    const std::vector<EdgeId>& GetForwardArcIds() const {
+        return forward_arcs_.arc_ids;
+    }
+    const std::vector<EdgeId>& GetBackwardArcIds() const {
+        return backward_arcs_.arc_ids;
+    }
+
+private:
+    // Дуги, ведущие к вершинам с большим рангом, в виде сжатых списков смежности
+    struct UpwardArcs {
+        void Build(size_t vertex_count, const std::vector<std::pair<VertexId, EdgeId>>& arcs) {
+            offsets.assign(vertex_count + 1, 0);
+            for (const auto& [vertex, arc_id] : arcs) {
+                ++offsets[vertex + 1];
+            }
+            for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+                offsets[vertex + 1] += offsets[vertex];
+            }
+            arc_ids.resize(arcs.size());
+            std::vector<size_t> positions(offsets.begin(), std::prev(offsets.end()));
+            for (const auto& [vertex, arc_id] : arcs) {
+                arc_ids[positions[vertex]++] = arc_id;
+            }
+        }
+
+        std::vector<size_t> offsets;
+        std::vector<EdgeId> arc_ids;
+    };
+
+    class Builder;
+
+    using SearchData = DijkstraSearchData<Weight>;
+
+    static SearchData& GetSearchData(size_t vertex_count, bool is_forward) {
+        static thread_local SearchData search_data[2];
+        SearchData& data = search_data[is_forward ? 0 : 1];
+        data.Prepare(vertex_count);
+        return data;
+    }
+
+    void UnpackArc(EdgeId arc_id, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    std::vector<Arc> arcs_;
+    UpwardArcs forward_arcs_;                   // дуги from -> to, rank(from) < rank(to), по вершине from
+    UpwardArcs backward_arcs_;                  // дуги from -> to, rank(from) > rank(to), по вершине to
+};
+
+// Последовательно стягивает вершины в порядке возрастания приоритета
+// (разность ребер с учетом стянутых соседей), добавляя сокращения там,
+// где ограниченный поиск свидетеля не нашел обходного пути.
+template <typename Weight>
+class ContractionHierarchyRouter<Weight>::Builder {
+public:
+    explicit Builder(ContractionHierarchyRouter& router)
+        : router_(router)
+        , vertex_count_(router.graph_.GetVertexCount())
+        , out_arcs_(vertex_count_)
+        , in_arcs_(vertex_count_)
+        , contracted_neighbours_(vertex_count_, 0)
+        , target_marks_(vertex_count_, 0) {
+    }
+
+    void Build() {
+        AddOriginalArcs();
+
+        using QueueItem = std::pair<int, VertexId>;
+        std::vector<QueueItem> queue;
+        queue.reserve(vertex_count_);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            queue.emplace_back(ComputePriority(vertex), vertex);
+        }
+        std::make_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            const VertexId vertex = queue.back().second;
+            queue.pop_back();
+
+            const int priority = ComputePriority(vertex);
+            if (!queue.empty() && priority > queue.front().first) {
+                queue.emplace_back(priority, vertex);
+                std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+                continue;
+            }
+            Contract(vertex);
+        }
+
+        router_.forward_arcs_.Build(vertex_count_, forward_);
+        router_.backward_arcs_.Build(vertex_count_, backward_);
+    }
+
+private:
+    static constexpr size_t MAX_WITNESS_SETTLED = 100;                // при стягивании вершины
+    static constexpr size_t MAX_ESTIMATE_WITNESS_SETTLED = 10;        // при оценке приоритета
+
+    void AddOriginalArcs() {
+        const Graph& graph = router_.graph_;
+        const size_t edge_count = graph.GetEdgeCount();
+        router_.arcs_.reserve(edge_count);
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            router_.arcs_.push_back(Arc{edge.from, edge.to, edge.weight});
+        }
+
+        // из параллельных ребер в иерархию попадает только самое легкое
+        std::vector<EdgeId> best_arc(vertex_count_, NO_ARC);
+        const FrozenIncidence<Weight>& incidence = graph.GetFrozenIncidence();
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            const size_t arcs_begin = incidence.offsets[vertex];
+            const size_t arcs_end = incidence.offsets[vertex + 1];
+            for (size_t arc = arcs_begin; arc < arcs_end; ++arc) {
+                const VertexId to = incidence.targets[arc];
+                if (to == vertex) {
+                    continue;
+                }
+                EdgeId& best = best_arc[to];
+                if (best == NO_ARC || router_.arcs_[best].from != vertex
+                    || incidence.weights[arc] < router_.arcs_[best].weight) {
+                    best = incidence.edge_ids[arc];
+                }
+            }
+            for (size_t arc = arcs_begin; arc < arcs_end; ++arc) {
+                const VertexId to = incidence.targets[arc];
+                const EdgeId edge_id = incidence.edge_ids[arc];
+                if (to != vertex && best_arc[to] == edge_id) {
+                    out_arcs_[vertex].push_back(edge_id);
+                    in_arcs_[to].push_back(edge_id);
+                }
+            }
+        }
+    }
+
+    const Arc& GetArc(EdgeId arc_id) const {
+        return router_.arcs_[arc_id];
+    }
+
+    // Ищет пути из source в оставшемся графе без вершины skipped не дороже limit
+    // и останавливается, когда все цели найдены; поиск ограничен по числу вершин,
+    // поэтому часть свидетелей может быть не найдена
+    void RunWitnessSearch(VertexId source, VertexId skipped, Weight limit, size_t target_count, size_t max_settled) {
+        witness_.Prepare(vertex_count_);
+        witness_.Reach(source, ZERO_WEIGHT, std::nullopt);
+        size_t settled = 0;
+        while (!witness_.heap.empty() && settled < max_settled && target_count > 0) {
+            const auto [weight, vertex] = witness_.Pop();
+            if (witness_.weights[vertex] < weight) {
+                continue;
+            }
+            if (limit < weight) {
+                break;
+            }
+            ++settled;
+            if (target_marks_[vertex] == target_mark_) {
+                --target_count;
+            }
+            for (const EdgeId arc_id : out_arcs_[vertex]) {
+                const Arc& arc = GetArc(arc_id);
+                if (arc.to == skipped) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + arc.weight;
+                if (!witness_.IsReached(arc.to) || candidate_weight < witness_.weights[arc.to]) {
+                    witness_.Reach(arc.to, candidate_weight, std::nullopt);
+                }
+            }
+        }
+    }
+
+    bool HasWitness(VertexId target, Weight weight) const {
+        return witness_.IsReached(target) && !(weight < witness_.weights[target]);
+    }
+
+    template <typename ShortcutHandler>
+    void ForEachShortcut(VertexId vertex, size_t max_settled, ShortcutHandler handler) {
+        for (const EdgeId in_arc_id : in_arcs_[vertex]) {
+            const Arc& in_arc = GetArc(in_arc_id);
+            Weight limit = ZERO_WEIGHT;
+            size_t target_count = 0;
+            ++target_mark_;
+            for (const EdgeId out_arc_id : out_arcs_[vertex]) {
+                const Arc& out_arc = GetArc(out_arc_id);
+                if (out_arc.to != in_arc.from) {
+                    limit = std::max(limit, in_arc.weight + out_arc.weight);
+                    target_marks_[out_arc.to] = target_mark_;
+                    ++target_count;
+                }
+            }
+            if (target_count == 0) {
+                continue;
+            }
+            RunWitnessSearch(in_arc.from, vertex, limit, target_count, max_settled);
+            for (const EdgeId out_arc_id : out_arcs_[vertex]) {
+                const Arc& out_arc = GetArc(out_arc_id);
+                if (out_arc.to == in_arc.from) {
+                    continue;
+                }
+                const Weight weight = in_arc.weight + out_arc.weight;
+                if (!HasWitness(out_arc.to, weight)) {
+                    handler(in_arc_id, out_arc_id, weight);
+                }
+            }
+        }
+    }
+
+    int ComputePriority(VertexId vertex) {
+        int shortcut_count = 0;
+        ForEachShortcut(vertex, MAX_ESTIMATE_WITNESS_SETTLED, [&shortcut_count](EdgeId, EdgeId, Weight) {
+            ++shortcut_count;
+        });
+        return shortcut_count
+            - static_cast<int>(in_arcs_[vertex].size() + out_arcs_[vertex].size())
+            + contracted_neighbours_[vertex];
+    }
+
+    void AddShortcut(EdgeId first_child, EdgeId second_child, Weight weight) {
+        const VertexId from = GetArc(first_child).from;
+        const VertexId to = GetArc(second_child).to;
+
+        auto& from_out_arcs = out_arcs_[from];
+        auto existing = std::find_if(from_out_arcs.begin(), from_out_arcs.end(), [this, to](EdgeId arc_id) {
+            return GetArc(arc_id).to == to;
+        });
+        if (existing != from_out_arcs.end() && !(weight < GetArc(*existing).weight)) {
+            return;
+        }
+
+        const EdgeId arc_id = router_.arcs_.size();
+        router_.arcs_.push_back(Arc{from, to, weight, first_child, second_child});
+        if (existing != from_out_arcs.end()) {
+            auto& to_in_arcs = in_arcs_[to];
+            *std::find(to_in_arcs.begin(), to_in_arcs.end(), *existing) = arc_id;
+            *existing = arc_id;
+        } else {
+            from_out_arcs.push_back(arc_id);
+            in_arcs_[to].push_back(arc_id);
+        }
+    }
+
+    static void RemoveArc(std::vector<EdgeId>& arcs, EdgeId arc_id) {
+        arcs.erase(std::find(arcs.begin(), arcs.end(), arc_id));
+    }
+
+    void Contract(VertexId vertex) {
+        std::vector<std::tuple<EdgeId, EdgeId, Weight>> shortcuts;
+        ForEachShortcut(vertex, MAX_WITNESS_SETTLED, [&shortcuts](EdgeId first_child, EdgeId second_child, Weight weight) {
+            shortcuts.emplace_back(first_child, second_child, weight);
+        });
+
+        for (const EdgeId arc_id : out_arcs_[vertex]) {
+            const VertexId neighbour = GetArc(arc_id).to;
+            forward_.emplace_back(vertex, arc_id);
+            RemoveArc(in_arcs_[neighbour], arc_id);
+            ++contracted_neighbours_[neighbour];
+        }
+        for (const EdgeId arc_id : in_arcs_[vertex]) {
+            const VertexId neighbour = GetArc(arc_id).from;
+            backward_.emplace_back(vertex, arc_id);
+            RemoveArc(out_arcs_[neighbour], arc_id);
+            ++contracted_neighbours_[neighbour];
+        }
+        out_arcs_[vertex].clear();
+        in_arcs_[vertex].clear();
+
+        for (const auto& [first_child, second_child, weight] : shortcuts) {
+            AddShortcut(first_child, second_child, weight);
+        }
+    }
+
+    ContractionHierarchyRouter& router_;
+    const size_t vertex_count_;
+    std::vector<std::vector<EdgeId>> out_arcs_;
+    std::vector<std::vector<EdgeId>> in_arcs_;
+    std::vector<int> contracted_neighbours_;
+    std::vector<std::pair<VertexId, EdgeId>> forward_;
+    std::vector<std::pair<VertexId, EdgeId>> backward_;
+    SearchData witness_;
+    std::vector<size_t> target_marks_;
+    size_t target_mark_ = 0;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+    : graph_(graph)
+{
+    Builder(*this).Build();
+}
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, std::vector<Arc> shortcuts,
+                                                               const std::vector<EdgeId>& forward_arc_ids,
+                                                               const std::vector<EdgeId>& backward_arc_ids)
+    : graph_(graph)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t edge_count = graph.GetEdgeCount();
+    arcs_.reserve(edge_count + shortcuts.size());
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        arcs_.push_back(Arc{edge.from, edge.to, edge.weight});
+    }
+    // дочерние дуги сокращения добавлены раньше него, поэтому распаковка всегда заканчивается
+    for (const Arc& shortcut : shortcuts) {
+        const EdgeId arc_id = arcs_.size();
+        if (shortcut.first_child >= arc_id || shortcut.second_child >= arc_id) {
+            throw std::invalid_argument("Shortcut children should precede the shortcut");
+        }
+        const Arc& first = arcs_[shortcut.first_child];
+        const Arc& second = arcs_[shortcut.second_child];
+        if (shortcut.from != first.from || first.to != second.from || second.to != shortcut.to
+            || shortcut.weight != first.weight + second.weight) {
+            throw std::invalid_argument("Shortcut does not match its children");
+        }
+        arcs_.push_back(shortcut);
+    }
+
+    const auto collect = [this](const std::vector<EdgeId>& arc_ids, bool is_forward) {
+        std::vector<std::pair<VertexId, EdgeId>> arcs;
+        arcs.reserve(arc_ids.size());
+        for (const EdgeId arc_id : arc_ids) {
+            if (arc_id >= arcs_.size()) {
+                throw std::invalid_argument("Arc id is out of range");
+            }
+            arcs.emplace_back(is_forward ? arcs_[arc_id].from : arcs_[arc_id].to, arc_id);
+        }
+        return arcs;
+    };
+    forward_arcs_.Build(vertex_count, collect(forward_arc_ids, true));
+    backward_arcs_.Build(vertex_count, collect(backward_arc_ids, false));
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackArc(EdgeId arc_id, std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack{arc_id};
+    while (!stack.empty()) {
+        const EdgeId current = stack.back();
+        stack.pop_back();
+        const Arc& arc = arcs_[current];
+        if (arc.first_child == NO_ARC) {
+            edges.push_back(current);
+        } else {
+            stack.push_back(arc.second_child);
+            stack.push_back(arc.first_child);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchData& forward = GetSearchData(vertex_count, true);
+    SearchData& backward = GetSearchData(vertex_count, false);
+    forward.Reach(from, ZERO_WEIGHT, std::nullopt);
+    backward.Reach(to, ZERO_WEIGHT, std::nullopt);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    // шаг поиска вверх по иерархии в одном направлении
+    const auto step = [&](SearchData& data, const SearchData& other, const UpwardArcs& upward_arcs, bool is_forward) {
+        const auto [weight, vertex] = data.Pop();
+        if (data.weights[vertex] < weight) {
+            return;
+        }
+        if (other.IsReached(vertex)) {
+            const Weight total_weight = weight + other.weights[vertex];
+            if (!best_weight || total_weight < *best_weight) {
+                best_weight = total_weight;
+                meeting_vertex = vertex;
+            }
+        }
+        for (size_t i = upward_arcs.offsets[vertex]; i < upward_arcs.offsets[vertex + 1]; ++i) {
+            const EdgeId arc_id = upward_arcs.arc_ids[i];
+            const Arc& arc = arcs_[arc_id];
+            const VertexId next = is_forward ? arc.to : arc.from;
+            const Weight candidate_weight = weight + arc.weight;
+            if (!data.IsReached(next) || candidate_weight < data.weights[next]) {
+                data.Reach(next, candidate_weight, arc_id);
+            }
+        }
+    };
+
+    const auto is_active = [&best_weight](const SearchData& data) {
+        return !data.heap.empty() && (!best_weight || data.heap.front().first < *best_weight);
+    };
+
+    while (is_active(forward) || is_active(backward)) {
+        if (is_active(forward)) {
+            step(forward, backward, forward_arcs_, true);
+        }
+        if (is_active(backward)) {
+            step(backward, forward, backward_arcs_, false);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> arcs;
+    for (std::optional<EdgeId> arc_id = forward.prev_edges[meeting_vertex];
+         arc_id;
+         arc_id = forward.prev_edges[arcs_[*arc_id].from])
+    {
+        arcs.push_back(*arc_id);
+    }
+    std::reverse(arcs.begin(), arcs.end());
+    for (std::optional<EdgeId> arc_id = backward.prev_edges[meeting_vertex];
+         arc_id;
+         arc_id = backward.prev_edges[arcs_[*arc_id].to])
+    {
+        arcs.push_back(*arc_id);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const EdgeId arc_id : arcs) {
+        UnpackArc(arc_id, edges);
+    }
+
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
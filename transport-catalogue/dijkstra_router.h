@@ -0,0 +1,263 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Рабочие массивы поиска, общие для всех запросов одного потока.
+// Метки поколений позволяют не очищать массивы перед каждым запросом.
+template <typename Weight>
+struct DijkstraSearchData {
+    using HeapItem = std::pair<Weight, VertexId>;
+
+    void Prepare(size_t vertex_count) {
+        if (marks.size() < vertex_count) {
+            weights.resize(vertex_count);
+            prev_edges.resize(vertex_count);
+            marks.resize(vertex_count, 0);
+        }
+        heap.clear();
+        if (++current_mark == 0) {
+            std::fill(marks.begin(), marks.end(), 0);
+            current_mark = 1;
+        }
+    }
+
+    bool IsReached(VertexId vertex) const {
+        return marks[vertex] == current_mark;
+    }
+
+    void Reach(VertexId vertex, Weight weight, std::optional<EdgeId> prev_edge) {
+        marks[vertex] = current_mark;
+        weights[vertex] = weight;
+        prev_edges[vertex] = prev_edge;
+        heap.emplace_back(weight, vertex);
+        std::push_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+    }
+
+    HeapItem Pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+        const HeapItem item = heap.back();
+        heap.pop_back();
+        return item;
+    }
+
+    std::vector<Weight> weights;
+    std::vector<std::optional<EdgeId>> prev_edges;
+    std::vector<uint32_t> marks;
+    std::vector<HeapItem> heap;
+    uint32_t current_mark = 0;
+};
+
+template <typename Weight>
+class DijkstraRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    // Маршрут с весами ребер edge_weight(edge_id) вместо записанных в графе: так один граф
+    // обслуживает разные варианты весов. Веса должны быть неотрицательными
+    template <typename EdgeWeight>
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, EdgeWeight edge_weight) const;
+
+    // Веса маршрутов из from во все вершины targets за один поиск,
+    // который останавливается, как только найдены все цели
+    std::vector<std::optional<Weight>> BuildWeights(VertexId from, const std::vector<VertexId>& targets) const;
+
+    // Вершины, достижимые из from с весом не больше max_weight, в порядке возрастания веса.
+    // Поиск не выходит за эту область, поэтому его стоимость зависит только от ее размера
+    std::vector<std::pair<VertexId, Weight>> BuildReachable(VertexId from, Weight max_weight) const;
+
+private:
+    using SearchData = DijkstraSearchData<Weight>;
+
+    template <typename ArcWeight>
+    std::optional<RouteInfo> FindRoute(VertexId from, VertexId to, ArcWeight arc_weight) const;
+
+    static SearchData& GetSearchData(size_t vertex_count) {
+        static thread_local SearchData search_data;
+        search_data.Prepare(vertex_count);
+        return search_data;
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    const FrozenIncidence<Weight>& incidence_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+    , incidence_(graph.GetFrozenIncidence())
+{
+    for (const Weight weight : incidence_.weights) {
+        if (weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    return FindRoute(from, to, [this](size_t arc) {
+        return incidence_.weights[arc];
+    });
+}
+
+template <typename Weight>
+template <typename EdgeWeight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                                                             EdgeWeight edge_weight) const {
+    return FindRoute(from, to, [this, &edge_weight](size_t arc) {
+        return static_cast<Weight>(edge_weight(incidence_.edge_ids[arc]));
+    });
+}
+
+template <typename Weight>
+template <typename ArcWeight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::FindRoute(VertexId from, VertexId to,
+                                                                                            ArcWeight arc_weight) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchData& data = GetSearchData(vertex_count);
+    data.Reach(from, ZERO_WEIGHT, std::nullopt);
+
+    bool is_found = false;
+    while (!data.heap.empty()) {
+        const auto [weight, vertex] = data.Pop();
+        if (data.weights[vertex] < weight) {
+            continue;
+        }
+        if (vertex == to) {
+            is_found = true;
+            break;
+        }
+        for (size_t arc = incidence_.offsets[vertex]; arc < incidence_.offsets[vertex + 1]; ++arc) {
+            const VertexId next = incidence_.targets[arc];
+            const Weight candidate_weight = weight + arc_weight(arc);
+            if (!data.IsReached(next) || candidate_weight < data.weights[next]) {
+                data.Reach(next, candidate_weight, incidence_.edge_ids[arc]);
+            }
+        }
+    }
+    if (!is_found) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = data.prev_edges[to];
+         edge_id;
+         edge_id = data.prev_edges[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{data.weights[to], std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>> DijkstraRouter<Weight>::BuildWeights(VertexId from,
+                                                                        const std::vector<VertexId>& targets) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    std::vector<bool> is_target(vertex_count, false);
+    size_t target_count = 0;
+    for (const VertexId target : targets) {
+        if (target >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (!is_target[target]) {
+            is_target[target] = true;
+            ++target_count;
+        }
+    }
+
+    SearchData& data = GetSearchData(vertex_count);
+    data.Reach(from, ZERO_WEIGHT, std::nullopt);
+    while (!data.heap.empty() && target_count > 0) {
+        const auto [weight, vertex] = data.Pop();
+        if (data.weights[vertex] < weight) {
+            continue;
+        }
+        if (is_target[vertex]) {
+            is_target[vertex] = false;
+            --target_count;
+        }
+        for (size_t arc = incidence_.offsets[vertex]; arc < incidence_.offsets[vertex + 1]; ++arc) {
+            const VertexId next = incidence_.targets[arc];
+            const Weight candidate_weight = weight + incidence_.weights[arc];
+            if (!data.IsReached(next) || candidate_weight < data.weights[next]) {
+                data.Reach(next, candidate_weight, incidence_.edge_ids[arc]);
+            }
+        }
+    }
+
+    // к остановке поиска все достижимые цели уже извлечены из кучи с окончательными весами
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(targets.size());
+    for (const VertexId target : targets) {
+        if (data.IsReached(target)) {
+            weights.push_back(data.weights[target]);
+        } else {
+            weights.push_back(std::nullopt);
+        }
+    }
+    return weights;
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::BuildReachable(VertexId from, Weight max_weight) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    if (max_weight < ZERO_WEIGHT) {
+        return reachable;
+    }
+    SearchData& data = GetSearchData(vertex_count);
+    data.Reach(from, ZERO_WEIGHT, std::nullopt);
+    while (!data.heap.empty()) {
+        const auto [weight, vertex] = data.Pop();
+        if (data.weights[vertex] < weight) {
+            continue;
+        }
+        reachable.emplace_back(vertex, weight);
+        for (size_t arc = incidence_.offsets[vertex]; arc < incidence_.offsets[vertex + 1]; ++arc) {
+            const VertexId next = incidence_.targets[arc];
+            const Weight candidate_weight = weight + incidence_.weights[arc];
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            if (!data.IsReached(next) || candidate_weight < data.weights[next]) {
+                data.Reach(next, candidate_weight, incidence_.edge_ids[arc]);
+            }
+        }
+    }
+    return reachable;
+}
+
+}  // namespace graph
@@ -19,6 +19,7 @@ Stop::Stop(const Stop& other) {
     this->stop_ = other.stop_;
     this->geo_ = other.geo_;
     this->stop_and_buses_ = other.stop_and_buses_;
+    this->vertex_id_ = other.vertex_id_;
 }
 
 Stop& Stop::operator=(const Stop& rhs) {
@@ -26,6 +27,7 @@ Stop& Stop::operator=(const Stop& rhs) {
         this->stop_ = rhs.stop_;
         this->geo_ = rhs.geo_;
         this->stop_and_buses_ = rhs.stop_and_buses_;
+        this->vertex_id_ = rhs.vertex_id_;
     }
     return *this;
 }
@@ -55,6 +57,18 @@ void Stop::AddBusFromRoute(const Bus* bus) const {
     stop_and_buses_.push_back(bus);
 }
 
+void Stop::RemoveBusFromRoute(const Bus* bus) const {
+    stop_and_buses_.erase(std::remove(stop_and_buses_.begin(), stop_and_buses_.end(), bus), stop_and_buses_.end());
+}
+
+size_t Stop::GetVertexId() const {
+    return vertex_id_;
+}
+
+void Stop::SetVertexId(size_t vertex_id) const {
+    vertex_id_ = vertex_id;
+}
+
 Bus::Bus(const std::string_view bus) : bus_(bus) {
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <limits>
 #include <map>
 #include <string>
 #include <string_view>
@@ -11,6 +13,8 @@ namespace domain {
 struct Bus;
 struct Stop {
 public:
+    static constexpr size_t NO_VERTEX = std::numeric_limits<size_t>::max();
+
     Stop() = default;
     explicit Stop(const std::string_view stop);
     explicit Stop(const std::tuple<std::string_view, double, double> info_stop);
@@ -24,11 +28,15 @@ public:
     std::pair<double, double> GetGeo() const;                       //возвращает географические координаты остановки
     std::vector<const Bus*> GetStopAndBuses() const;                //возвращает вектор с маршрутами, которые проходят через остановку
     void AddBusFromRoute(const Bus* bus) const;                     //добавление маршрута, который проходит через остановку
+    void RemoveBusFromRoute(const Bus* bus) const;                  //удаление маршрута, который больше не проходит через остановку
+    size_t GetVertexId() const;                                     //возвращает номер вершины графа маршрутов или NO_VERTEX
+    void SetVertexId(size_t vertex_id) const;                       //запоминает номер вершины графа маршрутов
 
 private:
     std::string_view stop_;                                         //название остановки
     std::pair<double, double> geo_= {0.0, 0.0};                     //географические координаты остановки
     mutable std::vector<const Bus*> stop_and_buses_;                //вектор с указателями на маршруты, которые проходят через остановку
+    mutable size_t vertex_id_ = NO_VERTEX;                          //номер вершины графа маршрутов
 };
 
 struct Bus {
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "graph.h"
+#include "min_plus.h"
+#include "parallel.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Предварительный расчет всех маршрутов, как в Router, но в двух плоских
+// массивах V x V (веса и последние ребра маршрутов) без std::optional:
+// отсутствие маршрута обозначается бесконечным весом, отсутствие ребра - NO_EDGE.
+// Релаксация выполняется блоками BLOCK_SIZE x BLOCK_SIZE, чтобы три
+// обрабатываемых блока помещались в кэш. Блоки одной фазы не зависят друг от друга
+// и обрабатываются в thread_count потоках; результат не зависит от числа потоков.
+// Веса всех маршрутов совпадают с Router, но сами маршруты могут отличаться: блоки
+// меняют порядок релаксации, и из нескольких маршрутов равного веса может быть выбран другой.
+// Если в графе есть ребра нулевого веса, из маршрутов равного веса выбирается маршрут
+// с меньшим числом ребер: так цепочки последних ребер не зацикливаются и на циклах нулевого веса.
+// Числа ребер хранятся только при расчете и только для таких графов: расчет с ними медленнее.
+// Таблицы можно не рассчитывать, а передать готовыми (например, отображенными из файла):
+// тогда маршрутизатор только читает их и не владеет памятью.
+template <typename Weight>
+class FlatRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+    using PackedEdgeId = uint32_t;
+
+    static constexpr size_t BLOCK_SIZE = 64;
+    static constexpr PackedEdgeId NO_EDGE = std::numeric_limits<PackedEdgeId>::max();
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                              ? std::numeric_limits<Weight>::infinity()
+                                              : std::numeric_limits<Weight>::max();
+
+    explicit FlatRouter(const Graph& graph, size_t thread_count = 1);
+    FlatRouter(const Graph& graph, const Weight* weights, const PackedEdgeId* prev_edges);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    size_t GetVertexCount() const {
+        return vertex_count_;
+    }
+    const Weight* GetWeights() const {
+        return weights_view_;
+    }
+    const PackedEdgeId* GetPrevEdges() const {
+        return prev_edges_view_;
+    }
+
+private:
+    bool HasZeroWeightEdges() const;
+
+    void InitializeRoutesInternalData();
+
+    void RelaxBlock(size_t block_from, size_t block_to, size_t block_through);
+
+    void RelaxRowThroughVertex(size_t row_from, size_t row_through, size_t column_begin, size_t column_end);
+
+    // релаксация с учетом числа ребер для графов с ребрами нулевого веса
+    void RelaxRowThroughVertexByHops(size_t row_from, size_t row_through, size_t column_begin, size_t column_end);
+
+    // таблицы от поврежденного индекса не должны зациклить или уронить запрос
+    [[noreturn]] static void ThrowBrokenTable() {
+        throw std::runtime_error("Flat routes table is inconsistent");
+    }
+
+    std::pair<size_t, size_t> GetBlockRange(size_t block) const {
+        return {block * BLOCK_SIZE, std::min(vertex_count_, (block + 1) * BLOCK_SIZE)};
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    size_t vertex_count_ = 0;
+    std::vector<Weight> weights_;                               // вес маршрута from -> to в ячейке from * V + to
+    std::vector<PackedEdgeId> prev_edges_;                      // последнее ребро маршрута from -> to
+    std::vector<uint32_t> hops_;                                // число ребер маршрута from -> to или пусто
+    const Weight* weights_view_ = nullptr;                      // таблицы, по которым строятся маршруты
+    const PackedEdgeId* prev_edges_view_ = nullptr;
+};
+
+template <typename Weight>
+FlatRouter<Weight>::FlatRouter(const Graph& graph, size_t thread_count)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , weights_(vertex_count_ * vertex_count_, INFINITE_WEIGHT)
+    , prev_edges_(vertex_count_ * vertex_count_, NO_EDGE)
+    , weights_view_(weights_.data())
+    , prev_edges_view_(prev_edges_.data())
+{
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for a flat routes table");
+    }
+    if (HasZeroWeightEdges()) {
+        hops_.assign(vertex_count_ * vertex_count_, 0);
+    }
+    InitializeRoutesInternalData();
+
+    const size_t block_count = (vertex_count_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if (block_count == 0) {
+        return;
+    }
+    const size_t other_count = block_count - 1;
+    for (size_t block_through = 0; block_through < block_count; ++block_through) {
+        const auto other_block = [block_through](size_t index) {
+            return index < block_through ? index : index + 1;
+        };
+
+        RelaxBlock(block_through, block_through, block_through);
+        // блоки в строке и столбце блока block_through зависят только от него
+        parallel::ForEachIndex(2 * other_count, thread_count, [&](size_t index) {
+            const size_t block = other_block(index / 2);
+            if (index % 2 == 0) {
+                RelaxBlock(block_through, block, block_through);
+            } else {
+                RelaxBlock(block, block_through, block_through);
+            }
+        });
+        // остальные блоки зависят только от строки и столбца
+        parallel::ForEachIndex(other_count, thread_count, [&](size_t index) {
+            const size_t block_from = other_block(index);
+            for (size_t i = 0; i < other_count; ++i) {
+                RelaxBlock(block_from, other_block(i), block_through);
+            }
+        });
+    }
+    hops_ = std::vector<uint32_t>{};
+}
+
+template <typename Weight>
+FlatRouter<Weight>::FlatRouter(const Graph& graph, const Weight* weights, const PackedEdgeId* prev_edges)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , weights_view_(weights)
+    , prev_edges_view_(prev_edges) {
+}
+
+template <typename Weight>
+bool FlatRouter<Weight>::HasZeroWeightEdges() const {
+    const FrozenIncidence<Weight>& incidence = graph_.GetFrozenIncidence();
+    return std::find(incidence.weights.begin(), incidence.weights.end(), ZERO_WEIGHT) != incidence.weights.end();
+}
+
+template <typename Weight>
+void FlatRouter<Weight>::InitializeRoutesInternalData() {
+    const FrozenIncidence<Weight>& incidence = graph_.GetFrozenIncidence();
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        weights_[vertex * vertex_count_ + vertex] = ZERO_WEIGHT;
+        for (size_t arc = incidence.offsets[vertex]; arc < incidence.offsets[vertex + 1]; ++arc) {
+            const Weight weight = incidence.weights[arc];
+            if (weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const size_t cell = vertex * vertex_count_ + incidence.targets[arc];
+            if (weight < weights_[cell]) {
+                weights_[cell] = weight;
+                if (!hops_.empty()) {
+                    hops_[cell] = 1;
+                }
+                prev_edges_[cell] = static_cast<PackedEdgeId>(incidence.edge_ids[arc]);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void FlatRouter<Weight>::RelaxBlock(size_t block_from, size_t block_to, size_t block_through) {
+    const auto [from_begin, from_end] = GetBlockRange(block_from);
+    const auto [to_begin, to_end] = GetBlockRange(block_to);
+    const auto [through_begin, through_end] = GetBlockRange(block_through);
+    for (size_t vertex_through = through_begin; vertex_through < through_end; ++vertex_through) {
+        for (size_t vertex_from = from_begin; vertex_from < from_end; ++vertex_from) {
+            RelaxRowThroughVertex(vertex_from, vertex_through, to_begin, to_end);
+        }
+    }
+}
+
+template <typename Weight>
+void FlatRouter<Weight>::RelaxRowThroughVertex(size_t row_from, size_t row_through, size_t column_begin, size_t column_end) {
+    const Weight weight_from = weights_[row_from * vertex_count_ + row_through];
+    if (weight_from == INFINITE_WEIGHT) {
+        return;
+    }
+    if (!hops_.empty()) {
+        RelaxRowThroughVertexByHops(row_from, row_through, column_begin, column_end);
+        return;
+    }
+    Weight* weights = weights_.data() + row_from * vertex_count_;
+    PackedEdgeId* prev_edges = prev_edges_.data() + row_from * vertex_count_;
+    const Weight* weights_through = weights_.data() + row_through * vertex_count_;
+    const PackedEdgeId* prev_edges_through = prev_edges_.data() + row_through * vertex_count_;
+
+    // маршрут через row_through никогда не улучшает ячейки row_through, поэтому
+    // последним ребром улучшенного маршрута всегда будет последнее ребро участка row_through -> to
+    if constexpr (std::is_same_v<Weight, double> || std::is_same_v<Weight, int32_t>) {
+        RelaxRowMinPlus(weight_from, weights_through + column_begin, prev_edges_through + column_begin,
+                        weights + column_begin, prev_edges + column_begin, column_end - column_begin);
+    } else {
+        for (size_t column = column_begin; column < column_end; ++column) {
+            if constexpr (!std::numeric_limits<Weight>::has_infinity) {
+                if (weights_through[column] == INFINITE_WEIGHT) {
+                    continue;
+                }
+            }
+            const Weight candidate_weight = weight_from + weights_through[column];
+            if (candidate_weight < weights[column]) {
+                weights[column] = candidate_weight;
+                prev_edges[column] = prev_edges_through[column];
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void FlatRouter<Weight>::RelaxRowThroughVertexByHops(size_t row_from, size_t row_through, size_t column_begin, size_t column_end) {
+    const Weight weight_from = weights_[row_from * vertex_count_ + row_through];
+    const uint32_t hops_from = hops_[row_from * vertex_count_ + row_through];
+    Weight* weights = weights_.data() + row_from * vertex_count_;
+    uint32_t* hops = hops_.data() + row_from * vertex_count_;
+    PackedEdgeId* prev_edges = prev_edges_.data() + row_from * vertex_count_;
+    const Weight* weights_through = weights_.data() + row_through * vertex_count_;
+    const uint32_t* hops_through = hops_.data() + row_through * vertex_count_;
+    const PackedEdgeId* prev_edges_through = prev_edges_.data() + row_through * vertex_count_;
+
+    if constexpr (std::is_same_v<Weight, double> || std::is_same_v<Weight, int32_t>) {
+        RelaxRowMinPlus(weight_from, hops_from, weights_through + column_begin, hops_through + column_begin,
+                        prev_edges_through + column_begin, weights + column_begin, hops + column_begin,
+                        prev_edges + column_begin, column_end - column_begin);
+    } else {
+        for (size_t column = column_begin; column < column_end; ++column) {
+            if (weights_through[column] == INFINITE_WEIGHT) {
+                continue;
+            }
+            const Weight candidate_weight = weight_from + weights_through[column];
+            const uint32_t candidate_hops = hops_from + hops_through[column];
+            if (candidate_weight < weights[column] || (candidate_weight == weights[column] && candidate_hops < hops[column])) {
+                weights[column] = candidate_weight;
+                hops[column] = candidate_hops;
+                prev_edges[column] = prev_edges_through[column];
+            }
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename FlatRouter<Weight>::RouteInfo> FlatRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const Weight weight = weights_view_[from * vertex_count_ + to];
+    if (weight == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    // у маршрута без повторов не больше V - 1 ребер
+    std::vector<EdgeId> edges;
+    for (PackedEdgeId edge_id = prev_edges_view_[from * vertex_count_ + to];
+         edge_id != NO_EDGE;
+         edge_id = prev_edges_view_[from * vertex_count_ + graph_.GetEdge(edge_id).from])
+    {
+        if (edges.size() + 1 >= vertex_count_ || edge_id >= graph_.GetEdgeCount()) {
+            ThrowBrokenTable();
+        }
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -3,7 +3,9 @@
 #include "domain.h"
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -23,6 +25,16 @@ struct Edge
     Weight weight;
 };
 
+// Замороженные списки смежности в сжатом построчном виде (CSR): дуги вершины v
+// занимают индексы [offsets[v], offsets[v + 1]) в массивах targets, weights и edge_ids
+template <typename Weight>
+struct FrozenIncidence {
+    std::vector<size_t> offsets;
+    std::vector<VertexId> targets;
+    std::vector<Weight> weights;
+    std::vector<EdgeId> edge_ids;
+};
+
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
@@ -33,33 +45,61 @@ public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    VertexId AddVertex();
+    // ребро остается в списке ребер, чтобы номера не менялись, но больше не исходит из вершины
+    void RemoveEdge(EdgeId edge_id);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // после заморозки смежность хранится только в CSR, списки вершин освобождаются;
+    // изменение замороженного графа сначала восстанавливает списки из CSR
+    void Freeze();
+    bool IsFrozen() const;
+    const FrozenIncidence<Weight>& GetFrozenIncidence() const;
+
 private:
+    void Thaw();
+
+    size_t vertex_count_ = 0;
     std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    std::vector<IncidenceList> incidence_lists_;                // списки смежности, пока граф не заморожен
+    FrozenIncidence<Weight> frozen_incidence_;                  // смежность замороженного графа
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+    : vertex_count_(vertex_count)
+    , incidence_lists_(vertex_count) {
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    Thaw();
+    incidence_lists_.at(edge.from).push_back(edges_.size());
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    return edges_.size() - 1;
+}
+
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    Thaw();
+    incidence_lists_.emplace_back();
+    return vertex_count_++;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    Thaw();
+    IncidenceList& incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+    incidence_list.erase(std::remove(incidence_list.begin(), incidence_list.end(), edge_id), incidence_list.end());
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
 }
 
 template <typename Weight>
@@ -75,6 +115,62 @@ const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    if (!IsFrozen()) {
+        return ranges::AsRange(incidence_lists_.at(vertex));
+    }
+    if (vertex >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const auto edge_ids = frozen_incidence_.edge_ids.begin();
+    return IncidentEdgesRange(edge_ids + frozen_incidence_.offsets[vertex], edge_ids + frozen_incidence_.offsets[vertex + 1]);
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Freeze() {
+    if (IsFrozen()) {
+        return;
+    }
+    FrozenIncidence<Weight> frozen;
+    frozen.offsets.reserve(vertex_count_ + 1);
+    frozen.targets.reserve(edges_.size());
+    frozen.weights.reserve(edges_.size());
+    frozen.edge_ids.reserve(edges_.size());
+    frozen.offsets.push_back(0);
+    for (const auto& incidence_list : incidence_lists_) {
+        for (const EdgeId edge_id : incidence_list) {
+            frozen.targets.push_back(edges_[edge_id].to);
+            frozen.weights.push_back(edges_[edge_id].weight);
+            frozen.edge_ids.push_back(edge_id);
+        }
+        frozen.offsets.push_back(frozen.targets.size());
+    }
+    frozen_incidence_ = std::move(frozen);
+    incidence_lists_ = std::vector<IncidenceList>{};
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Thaw() {
+    if (!IsFrozen()) {
+        return;
+    }
+    incidence_lists_.assign(vertex_count_, IncidenceList{});
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        const auto edge_ids = frozen_incidence_.edge_ids.begin();
+        incidence_lists_[vertex].assign(edge_ids + frozen_incidence_.offsets[vertex], edge_ids + frozen_incidence_.offsets[vertex + 1]);
+    }
+    frozen_incidence_ = {};
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return !frozen_incidence_.offsets.empty();
+}
+
+template <typename Weight>
+const FrozenIncidence<Weight>& DirectedWeightedGraph<Weight>::GetFrozenIncidence() const {
+    if (!IsFrozen()) {
+        throw std::logic_error("Graph should be frozen before routing");
+    }
+    return frozen_incidence_;
 }
 }  // namespace graph
\ No newline at end of file
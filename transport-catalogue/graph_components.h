@@ -0,0 +1,119 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Компоненты связности графа для ответа "маршрута нет" без поиска.
+// Компоненты сильной связности пронумерованы алгоритмом Тарьяна в обратном
+// топологическом порядке: если из компоненты A есть дуга в компоненту B, то B < A.
+// Поэтому маршрут from -> to возможен, только если from и to лежат в одной компоненте
+// слабой связности и strong[to] <= strong[from]. Обратное неверно: совпадение слабых
+// компонент и порядок сильных не гарантируют маршрута, тогда нужен поиск.
+struct GraphComponents {
+    static constexpr uint32_t NO_COMPONENT = std::numeric_limits<uint32_t>::max();
+
+    bool MayReach(VertexId from, VertexId to) const {
+        return weak[from] == weak[to] && strong[to] <= strong[from];
+    }
+
+    std::vector<uint32_t> strong;                               // номер компоненты сильной связности вершины
+    std::vector<uint32_t> weak;                                 // номер компоненты слабой связности вершины
+};
+
+// Граф должен быть заморожен; удаленные ребра не учитываются
+template <typename Weight>
+GraphComponents ComputeComponents(const DirectedWeightedGraph<Weight>& graph) {
+    const FrozenIncidence<Weight>& incidence = graph.GetFrozenIncidence();
+    const size_t vertex_count = graph.GetVertexCount();
+    GraphComponents components;
+    components.strong.assign(vertex_count, GraphComponents::NO_COMPONENT);
+
+    // алгоритм Тарьяна без рекурсии: в стеке вызовов вершина и следующая ее дуга
+    constexpr size_t NOT_VISITED = std::numeric_limits<size_t>::max();
+    std::vector<size_t> order(vertex_count, NOT_VISITED);
+    std::vector<size_t> low(vertex_count, 0);
+    std::vector<VertexId> component_stack;
+    std::vector<std::pair<VertexId, size_t>> call_stack;
+    size_t visit_count = 0;
+    uint32_t strong_count = 0;
+    const auto visit = [&](VertexId vertex) {
+        order[vertex] = low[vertex] = visit_count++;
+        component_stack.push_back(vertex);
+        call_stack.emplace_back(vertex, incidence.offsets[vertex]);
+    };
+    for (VertexId start = 0; start < vertex_count; ++start) {
+        if (order[start] != NOT_VISITED) {
+            continue;
+        }
+        visit(start);
+        while (!call_stack.empty()) {
+            const VertexId vertex = call_stack.back().first;
+            const size_t arc = call_stack.back().second;
+            if (arc < incidence.offsets[vertex + 1]) {
+                ++call_stack.back().second;
+                const VertexId next = incidence.targets[arc];
+                if (order[next] == NOT_VISITED) {
+                    visit(next);
+                } else if (components.strong[next] == GraphComponents::NO_COMPONENT) {
+                    // next еще в стеке компонент
+                    low[vertex] = std::min(low[vertex], order[next]);
+                }
+                continue;
+            }
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                const VertexId parent = call_stack.back().first;
+                low[parent] = std::min(low[parent], low[vertex]);
+            }
+            if (low[vertex] == order[vertex]) {
+                VertexId member;
+                do {
+                    member = component_stack.back();
+                    component_stack.pop_back();
+                    components.strong[member] = strong_count;
+                } while (member != vertex);
+                ++strong_count;
+            }
+        }
+    }
+
+    // компоненты слабой связности - системой непересекающихся множеств по дугам
+    std::vector<VertexId> parents(vertex_count);
+    std::iota(parents.begin(), parents.end(), VertexId{0});
+    const auto find_root = [&parents](VertexId vertex) {
+        while (parents[vertex] != vertex) {
+            parents[vertex] = parents[parents[vertex]];
+            vertex = parents[vertex];
+        }
+        return vertex;
+    };
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t arc = incidence.offsets[vertex]; arc < incidence.offsets[vertex + 1]; ++arc) {
+            const VertexId from_root = find_root(vertex);
+            const VertexId to_root = find_root(incidence.targets[arc]);
+            if (from_root != to_root) {
+                parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+            }
+        }
+    }
+    components.weak.assign(vertex_count, GraphComponents::NO_COMPONENT);
+    uint32_t weak_count = 0;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const VertexId root = find_root(vertex);
+        if (components.weak[root] == GraphComponents::NO_COMPONENT) {
+            components.weak[root] = weak_count++;
+        }
+        components.weak[vertex] = components.weak[root];
+    }
+    return components;
+}
+
+}  // namespace graph
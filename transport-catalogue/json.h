@@ -82,4 +82,7 @@ Document Load(std::istream& input);
 
 void Print(const Document& doc, std::ostream& output);
 
+// Вывод в одну строку: без переводов строк и отступов
+void PrintCompact(const Document& doc, std::ostream& output);
+
 }  // namespace json
\ No newline at end of file
@@ -2,6 +2,79 @@
 
 namespace catalogue {
 namespace reader {
+namespace {
+//количество из настроек: отрицательное значение при переводе в size_t стало бы огромным
+size_t ReadCount(const json::Node& value, const std::string& key) {
+    const int count = value.AsInt();
+    if (count < 0) {
+        throw std::invalid_argument(key + " should be non-negative");
+    }
+    return static_cast<size_t>(count);
+}
+
+//json хранит целые в int, поэтому счетчики долго работающего сервера ограничиваются сверху
+int ToJsonCount(uint64_t count) {
+    return static_cast<int>(std::min<uint64_t>(count, std::numeric_limits<int>::max()));
+}
+
+json::Dict MakeCacheStats(const cache::CacheStats& stats) {
+    using namespace std::literals;
+    return json::Builder{}.StartDict()
+                              .Key("hits"s).Value(ToJsonCount(stats.hits))
+                              .Key("misses"s).Value(ToJsonCount(stats.misses))
+                              .Key("entries"s).Value(ToJsonCount(stats.entries))
+                              .Key("bytes"s).Value(ToJsonCount(stats.bytes))
+                              .EndDict()
+                              .Build().AsDict();
+}
+
+json::Dict MakeErrorAnswer(int query_id, const std::string& message) {
+    using namespace std::literals;
+    return json::Builder{}.StartDict()
+                              .Key("request_id"s).Value(query_id)
+                              .Key("error_message"s).Value(message)
+                              .EndDict()
+                              .Build().AsDict();
+}
+
+//изменение заполненного справочника: Stop добавляет остановку, Bus добавляет маршрут, RemoveBus удаляет.
+//Граф правится на месте, маршрутизатор обновляется без перестроения с нуля
+void ApplyUpdateRequest(head::TransportCatalogue& tc, routing::RoutingSettings& rt, const json::Dict& request) {
+    using namespace std::literals;
+    const stat::RequestHandler rh(tc);
+    const std::string& type = request.at("type"s).AsString();
+    const std::string& name = request.at("name"s).AsString();
+    if (type == "Stop"s) {
+        //остановка без маршрутов в граф не входит: ее вершина выделится, когда через нее пройдет новый маршрут.
+        //Расстояния проверяются до добавления, чтобы ошибка не оставила остановку без них
+        std::vector<std::pair<const Stop*, int>> distances;
+        if (auto it = request.find("road_distances"s); it != request.end()) {
+            for (const auto& [stop, distance] : it->second.AsDict()) {
+                distances.emplace_back(rh.GetStopPtr(stop), distance.AsInt());
+            }
+        }
+        const Stop* stop_ptr = tc.InsertStop(name, request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble());
+        std::vector<std::pair<std::pair<const Stop*, const Stop*>, int>> stops_distance;
+        for (const auto& [finish_ptr, distance] : distances) {
+            stops_distance.push_back({{stop_ptr, finish_ptr}, distance});
+        }
+        tc.AddDistance(stops_distance);
+    } else if (type == "Bus"s) {
+        std::vector<const Stop*> stops;
+        for (const auto& stop : request.at("stops"s).AsArray()) {
+            stops.push_back(rh.GetStopPtr(stop.AsString()));
+        }
+        routing::AddBus(tc, rt, name, request.at("is_roundtrip"s).AsBool(), std::move(stops));
+    } else if (type == "RemoveBus"s) {
+        if (!routing::RemoveBus(tc, rt, name)) {
+            throw std::invalid_argument("Bus not found"s);
+        }
+    } else {
+        throw std::invalid_argument("Unknown update request "s + type);
+    }
+}
+}//namespace
+
 void JSONReader::ParseQuery(std::istream& is, Query &q) {
     json::Dict text_query{json::Load(is).GetRoot().AsDict()};
     for (const auto& [key, val] : text_query) {
@@ -23,6 +96,12 @@ void JSONReader::ParseQuery(std::istream& is, Query &q) {
             }
         }
 
+        if (key == "update_requests"s) {
+            for (const auto& v : val.AsArray()) {
+                q.text_update_.push_back(v.AsDict());
+            }
+        }
+
         if (key == "render_settings"s) {
             q.text_render_settings_ = val.AsDict();
         }
@@ -30,6 +109,10 @@ void JSONReader::ParseQuery(std::istream& is, Query &q) {
         if (key == "routing_settings"s) {
             q.text_routing_settings_ = val.AsDict();
         }
+
+        if (key == "stat_threads"s) {
+            q.stat_threads_ = ReadCount(val, key);
+        }
     }
 }
 
@@ -125,6 +208,39 @@ void JSONReader::AddRoutingSettings(routing::RoutingSettings& rt, const json::Di
     using namespace std::literals;
     rt.bus_wait_time_ = settings.at("bus_wait_time"s).AsDouble();
     rt.bus_velocity_ = settings.at("bus_velocity"s).AsDouble();
+    if (auto it = settings.find("router_type"s); it != settings.end()) {
+        rt.router_type_ = routing::ParseRouterType(it->second.AsString());
+    }
+    if (auto it = settings.find("graph_model"s); it != settings.end()) {
+        rt.graph_model_ = routing::ParseGraphModel(it->second.AsString());
+    }
+    if (auto it = settings.find("vertex_order"s); it != settings.end()) {
+        rt.vertex_order_ = routing::ParseVertexOrder(it->second.AsString());
+    }
+    if (auto it = settings.find("router_threads"s); it != settings.end()) {
+        rt.router_threads_ = ReadCount(it->second, it->first);
+    }
+    if (auto it = settings.find("router_landmarks"s); it != settings.end()) {
+        rt.router_landmarks_ = ReadCount(it->second, it->first);
+    }
+    if (auto it = settings.find("router_spt_trees"s); it != settings.end()) {
+        rt.router_spt_trees_ = ReadCount(it->second, it->first);
+    }
+    if (auto it = settings.find("router_spt_bytes"s); it != settings.end()) {
+        rt.router_spt_bytes_ = ReadCount(it->second, it->first);
+    }
+    if (auto it = settings.find("router_index_file"s); it != settings.end()) {
+        rt.router_index_file_ = it->second.AsString();
+    }
+    if (auto it = settings.find("route_cache_entries"s); it != settings.end()) {
+        rt.route_cache_entries_ = ReadCount(it->second, it->first);
+    }
+    if (auto it = settings.find("route_cache_bytes"s); it != settings.end()) {
+        rt.route_cache_bytes_ = ReadCount(it->second, it->first);
+    }
+    if (rt.route_cache_entries_ > 0 || rt.route_cache_bytes_ > 0) {
+        rt.route_cache_ = std::make_unique<routing::RouteCache>(rt.route_cache_entries_, rt.route_cache_bytes_);
+    }
 }
 
 json::Dict JSONReader::MakeJsonDocStopsForBus(int query_id, const stat::StopsForBusStat& r) {
@@ -218,6 +334,108 @@ json::Dict JSONReader::MakeJsonDocForRoute(int query_id, const std::optional<rou
     return result.GetNode().AsDict();
 }
 
+json::Dict JSONReader::MakeJsonDocForRouteMatrix(int query_id, const routing::RouteMatrix& route_matrix) {
+    using namespace std::literals;
+    json::Builder res{};
+    res.StartArray();
+    for (size_t row = 0; row < route_matrix.source_count_; ++row) {
+        res.StartArray();
+        for (size_t column = 0; column < route_matrix.target_count_; ++column) {
+            const std::optional<double>& total_time = route_matrix.total_times_[row * route_matrix.target_count_ + column];
+            if (total_time) {
+                res.Value(*total_time);
+            } else {
+                res.Value(nullptr);
+            }
+        }
+        res.EndArray();
+    }
+    res.EndArray().Build();
+
+    json::Builder result{};
+    result.StartDict()
+                .Key("request_id"s).Value(query_id)
+                .Key("total_times"s).Value(res.GetNode().AsArray())
+                .EndDict()
+                .Build();
+    return result.GetNode().AsDict();
+}
+
+json::Dict JSONReader::MakeJsonDocForIsochrone(int query_id, const std::optional<std::vector<routing::ReachableStop>>& reachable_stops) {
+    json::Builder result{};
+    using namespace std::literals;
+    if (!reachable_stops) {
+        result.StartDict()
+                    .Key("request_id"s).Value(query_id)
+                    .Key("error_message"s).Value("not found"s)
+                    .EndDict()
+                    .Build();
+    } else {
+        json::Builder res{};
+        res.StartArray();
+        for (const auto& reachable_stop : *reachable_stops) {
+            res.StartDict()
+                    .Key("stop_name"s).Value(std::string(reachable_stop.stop_->GetStop()))
+                    .Key("time"s).Value(reachable_stop.time_)
+                    .EndDict();
+        }
+        res.EndArray().Build();
+
+        result.StartDict()
+                    .Key("request_id"s).Value(query_id)
+                    .Key("stops"s).Value(res.GetNode().AsArray())
+                    .EndDict()
+                    .Build();
+    }
+    return result.GetNode().AsDict();
+}
+
+json::Dict JSONReader::MakeJsonDocForRouterStats(int query_id, const routing::RouterStats& stats) {
+    using namespace std::literals;
+    json::Dict result{{"request_id"s, query_id}};
+    if (stats.route_cache_) {
+        result.emplace("route_cache"s, MakeCacheStats(*stats.route_cache_));
+    }
+    if (stats.spt_cache_) {
+        result.emplace("spt_cache"s, MakeCacheStats(*stats.spt_cache_));
+    }
+    if (stats.min_plus_kernel_) {
+        result.emplace("min_plus_kernel"s, *stats.min_plus_kernel_);
+    }
+    if (stats.shortcut_count_) {
+        result.emplace("shortcut_count"s, ToJsonCount(*stats.shortcut_count_));
+    }
+    if (stats.landmark_count_) {
+        result.emplace("landmark_count"s, ToJsonCount(*stats.landmark_count_));
+    }
+    return result;
+}
+
+uint64_t ComputeInputHash(const Query& q) {
+    //FNV-1a по тексту запросов на заполнение базы и влияющих на граф настроек маршрутизации
+    uint64_t hash = 14695981039346656037ull;
+    const auto add = [&hash](const json::Node& node) {
+        std::ostringstream out;
+        json::Print(json::Document{node}, out);
+        for (const unsigned char c : out.str()) {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+    };
+
+    using namespace std::literals;
+    for (const auto& stop : q.text_base_stops_) {
+        add(stop);
+    }
+    for (const auto& bus : q.text_base_buses_) {
+        add(bus);
+    }
+    json::Dict routing_settings = q.text_routing_settings_;
+    routing_settings.erase("router_threads"s);
+    routing_settings.erase("router_index_file"s);
+    add(routing_settings);
+    return hash;
+}
+
 void FillCatalogue(head::TransportCatalogue& tc, Query& q, renderer::RenderSettings& r, renderer::MapObjects& m, routing::RoutingSettings& rt, std::istream& is) {
     stat::RequestHandler rh(tc);
     JSONReader reader;
@@ -268,6 +486,58 @@ void FillCatalogue(head::TransportCatalogue& tc, Query& q, renderer::RenderSetti
         }
     }
 
+    if (!q.text_routing_settings_.empty()) {
+        {
+            using namespace std::literals;
+            LOG_DURATION("AddRoutingSettings"s);
+            reader.AddRoutingSettings(rt, std::move(q.text_routing_settings_));
+        }
+
+        const bool is_index_used = !rt.router_index_file_.empty() && rt.IsGraphRequired();
+        const uint64_t input_hash = is_index_used ? ComputeInputHash(q) : 0;
+        bool is_index_loaded = false;
+        if (is_index_used) {
+            using namespace std::literals;
+            LOG_DURATION("LoadRouterIndex"s);
+            is_index_loaded = routing::LoadRouterIndex(rt, rh, input_hash);
+        }
+
+        if (!is_index_loaded) {
+            {
+                using namespace std::literals;
+                LOG_DURATION("BuildGraph"s);
+                stat::RequestHandler rh(tc);
+                if (rt.IsGraphRequired()) {
+                    rt.BuildGraph(rh);
+                }
+            }
+            {
+                using namespace std::literals;
+                LOG_DURATION("BuildRouter"s);
+                rt.BuildRouter(rh);
+            }
+            if (is_index_used) {
+                using namespace std::literals;
+                LOG_DURATION("SaveRouterIndex"s);
+                //индекс только ускоряет следующий запуск: без него маршрутизатор уже построен и работает
+                try {
+                    routing::SaveRouterIndex(rt, input_hash);
+                } catch (const std::exception& e) {
+                    std::cerr << "Cannot save router index: "s << e.what() << std::endl;
+                }
+            }
+        }
+    }
+
+    //изменения применяются к построенному маршрутизатору, а карта рисуется уже по измененному справочнику
+    if (!q.text_update_.empty()) {
+        using namespace std::literals;
+        LOG_DURATION("UpdateBuses"s);
+        for (const auto& update : std::move(q.text_update_)) {
+            ApplyUpdateRequest(tc, rt, update.AsDict());
+        }
+    }
+
     if (!q.text_render_settings_.empty()) {
         {
             using namespace std::literals;
@@ -280,72 +550,132 @@ void FillCatalogue(head::TransportCatalogue& tc, Query& q, renderer::RenderSetti
             renderer::MapRenderer(rh, r, m);
         }
     }
+}
 
-    if (!q.text_routing_settings_.empty()) {
-        {
-            using namespace std::literals;
-            LOG_DURATION("AddRoutingSettings"s);
-            reader.AddRoutingSettings(rt, std::move(q.text_routing_settings_));
+std::optional<json::Dict> ExecuteStatRequest(const stat::RequestHandler& rh, const renderer::MapObjects& m,
+                                             const routing::RoutingSettings& rt, const json::Dict& query) {
+    using namespace std::literals;
+    JSONReader maker;
+    const int query_id = query.at("id"s).AsInt();
+    const std::string& type = query.at("type"s).AsString();
+
+    if (type == "Stop"s) {
+        return maker.MakeJsonDocBusesForStop(query_id, stat::GetBusesForStop(rh, query.at("name"s).AsString()));
+    }
+    if (type == "Bus"s) {
+        return maker.MakeJsonDocStopsForBus(query_id, stat::GetStopsForBus(rh, query.at("name"s).AsString()));
+    }
+    if (type == "Map"s) {
+        std::ostringstream output;
+        m.map_object_detail_.Render(output);
+        std::string map_as_string(output.str());
+        return json::Builder{}.StartDict()
+                                  .Key("request_id"s).Value(query_id)
+                                  .Key("map"s).Value(map_as_string)
+                                  .EndDict()
+                                  .Build().AsDict();
+    }
+    if (type == "Route"s) {
+        const Stop* from_ptr = rh.FindStop(query.at("from"s).AsString());
+        const Stop* to_ptr = rh.FindStop(query.at("to"s).AsString());
+        std::optional<routing::RoutingProfile> profile;
+        const auto wait_it = query.find("bus_wait_time"s);
+        const auto velocity_it = query.find("bus_velocity"s);
+        if (wait_it != query.end() || velocity_it != query.end()) {
+            profile = routing::RoutingProfile{rt.bus_wait_time_, rt.bus_velocity_};
+            //время ожидания в графе целое, поэтому дробное не округляется молча, а отклоняется
+            const bool is_wait_valid = wait_it == query.end() || wait_it->second.IsInt();
+            if (is_wait_valid && wait_it != query.end()) {
+                profile->bus_wait_time_ = wait_it->second.AsInt();
+            }
+            if (velocity_it != query.end()) {
+                profile->bus_velocity_ = velocity_it->second.AsDouble();
+            }
+            if (!is_wait_valid || !profile->IsValid()) {
+                return MakeErrorAnswer(query_id, "invalid routing profile"s);
+            }
         }
-        {
-            using namespace std::literals;
-            LOG_DURATION("BuildGraph"s);
-            stat::RequestHandler rh(tc);
-            rt.BuildGraph(rh);
+        return maker.MakeJsonDocForRoute(query_id, routing::GetRoutingItems(rt, from_ptr, to_ptr, profile));
+    }
+    if (type == "RouteMatrix"s) {
+        std::vector<const Stop*> sources;
+        std::vector<const Stop*> targets;
+        for (const auto& stop : query.at("sources"s).AsArray()) {
+            sources.push_back(rh.FindStop(stop.AsString()));
         }
+        for (const auto& stop : query.at("targets"s).AsArray()) {
+            targets.push_back(rh.FindStop(stop.AsString()));
+        }
+        return maker.MakeJsonDocForRouteMatrix(query_id, routing::GetRouteMatrix(rt, sources, targets));
+    }
+    if (type == "Isochrone"s) {
+        //изохрона - поиск по графу из одной вершины, а RAPTOR графа не строит
+        if (!rt.IsGraphRequired()) {
+            return MakeErrorAnswer(query_id, "isochrone is not supported by router_type raptor"s);
+        }
+        const Stop* from_ptr = rh.FindStop(query.at("from"s).AsString());
+        const double max_time = query.at("max_time"s).AsDouble();
+        return maker.MakeJsonDocForIsochrone(query_id, routing::GetIsochrone(rt, from_ptr, max_time));
+    }
+    if (type == "RouterStats"s) {
+        return maker.MakeJsonDocForRouterStats(query_id, routing::GetRouterStats(rt));
     }
+    return std::nullopt;
 }
 
-void ExecuteStatRequests(head::TransportCatalogue& tc, reader::Query& q, renderer::MapObjects& m, routing::RoutingSettings& rt, std::ostream& os) {
+void ExecuteStatRequests(const head::TransportCatalogue& tc, const Query& q, const renderer::MapObjects& m,
+                         const routing::RoutingSettings& rt, std::ostream& os) {
     using namespace std::literals;
     LOG_DURATION("GetInfo"s);
 
-    stat::RequestHandler rh(tc);
-
-    graph::Router<double> router(rt.graph_);
-
-    JSONReader maker;
-    int query_id = 0;
-    std::string_view name;
+    const stat::RequestHandler rh(tc);
+
+    //запросы раздаются потокам по одному, поэтому долгие запросы маршрутов не задерживают остальные;
+    //ответы записываются по номеру запроса и выводятся в исходном порядке
+    std::vector<std::optional<json::Dict>> answers(q.text_stat_.size());
+    parallel::ForEachIndex(q.text_stat_.size(), q.stat_threads_, [&](size_t index) {
+        const json::Dict& query = q.text_stat_[index].AsDict();
+        //ошибка одного запроса, как и в режиме сервера, не прерывает ответы на остальные
+        try {
+            answers[index] = ExecuteStatRequest(rh, m, rt, query);
+        } catch (const std::exception& e) {
+            answers[index] = MakeErrorAnswer(query.at("id"s).AsInt(), e.what());
+        }
+    });
 
     json::Builder result{};
     result.StartArray();
-    if (!q.text_stat_.empty()) {
-        for (const auto& query : q.text_stat_) {
-            query_id = query.AsDict().at("id"s).AsInt();
-            if (query.AsDict().at("type"s) == "Stop"s) {
-                name = query.AsDict().at("name"s).AsString();
-                result.Value(maker.MakeJsonDocBusesForStop(query_id, stat::GetBusesForStop(rh, name)));
-                continue;
-            }
-            if (query.AsDict().at("type"s) == "Bus"s) {
-                name = query.AsDict().at("name"s).AsString();
-                result.Value(maker.MakeJsonDocStopsForBus(query_id, stat::GetStopsForBus(rh, name)));
-                continue;
-            }
-            if (query.AsDict().at("type"s) == "Map"s) {
-                std::ostringstream output;
-                m.map_object_detail_.Render(output);
-                std::string map_as_string(output.str());
-                result.Value(json::Builder{}.StartDict()
-                                                .Key("request_id"s).Value(query_id)
-                                                .Key("map"s).Value(map_as_string)
-                                                .EndDict()
-                                                .Build().AsDict());
-                continue;
-            }
-            if (query.AsDict().at("type"s) == "Route"s) {
-                std::string from = query.AsDict().at("from"s).AsString();
-                std::string to = query.AsDict().at("to"s).AsString();
-                const Stop* from_ptr = rh.FindStop(from);
-                const Stop* to_ptr = rh.FindStop(to);
-                result.Value(maker.MakeJsonDocForRoute(query_id, routing::GetRoutingItems(router, rt, from_ptr, to_ptr)));
-                continue;
-            }
+    for (std::optional<json::Dict>& answer : answers) {
+        if (answer) {
+            result.Value(std::move(*answer));
         }
     }
     result.EndArray().Build();
     json::Print(json::Document{result.GetNode().AsArray()}, os);
+
+    PrintRouterStats(rt, std::cerr);
+}
+
+void PrintRouterStats(const routing::RoutingSettings& rt, std::ostream& os) {
+    using namespace std::literals;
+    const routing::RouterStats stats = routing::GetRouterStats(rt);
+    if (stats.route_cache_) {
+        os << "RouteCache: "s << stats.route_cache_->hits << " hits, "s << stats.route_cache_->misses << " misses, "s
+           << stats.route_cache_->entries << " entries, "s << stats.route_cache_->bytes << " bytes"s << std::endl;
+    }
+    if (stats.spt_cache_) {
+        os << "SptCache: "s << stats.spt_cache_->hits << " hits, "s << stats.spt_cache_->misses << " misses, "s
+           << stats.spt_cache_->entries << " entries, "s << stats.spt_cache_->bytes << " bytes"s << std::endl;
+    }
+    if (stats.min_plus_kernel_) {
+        os << "MinPlusKernel: "s << *stats.min_plus_kernel_ << std::endl;
+    }
+    if (stats.shortcut_count_) {
+        os << "ContractionHierarchy: "s << *stats.shortcut_count_ << " shortcuts"s << std::endl;
+    }
+    if (stats.landmark_count_) {
+        os << "AStar: "s << *stats.landmark_count_ << " landmarks"s << std::endl;
+    }
 }
 }//namespace reader
 }//namespace catalogue
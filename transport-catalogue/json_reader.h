@@ -8,9 +8,14 @@
 #include "transport_router.h"
 #include "transport_catalogue.h"
 #include "request_handler.h"
+#include "router_index.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <sstream>
 #include <utility>
 #include <string>
 #include <tuple>
@@ -25,8 +30,10 @@ struct Query {
     json::Array text_base_stops_;                               //вектор с запросами на добавление информации об остановках
     json::Array text_base_buses_;                               //вектор с запросами на добавление информации о маршрутах
     json::Array text_stat_;                                     //вектор с запросами на предоставление информации
+    json::Array text_update_;                                   //вектор с запросами на изменение маршрутов после построения маршрутизатора
     json::Dict text_render_settings_;                           //словарь с настройками визуализации карты
     json::Dict text_routing_settings_;                          //словарь с настройками маршрутизации
+    size_t stat_threads_ = 1;                                   //потоков для ответов на запросы (0 - все ядра)
 };
 
 class JSONReader {
@@ -52,10 +59,26 @@ public:
     json::Dict MakeJsonDocBusesForStop(int query_id, const stat::BusesForStopStat &r);
 
     json::Dict MakeJsonDocForRoute(int query_id, const std::optional<routing::RouteInform>& route_inform);
+
+    json::Dict MakeJsonDocForRouteMatrix(int query_id, const routing::RouteMatrix& route_matrix);
+
+    json::Dict MakeJsonDocForIsochrone(int query_id, const std::optional<std::vector<routing::ReachableStop>>& reachable_stops);
+
+    json::Dict MakeJsonDocForRouterStats(int query_id, const routing::RouterStats& stats);
 };
 
+uint64_t ComputeInputHash(const Query& q);                      //хэш исходных данных и настроек маршрутизации для проверки сохраненного индекса
+
 void FillCatalogue(head::TransportCatalogue& tc, Query& q, renderer::RenderSettings& r, renderer::MapObjects& m, routing::RoutingSettings& rt, std::istream& is);
 
-void ExecuteStatRequests(head::TransportCatalogue& tc, Query& q, renderer::MapObjects& m, routing::RoutingSettings& rt, std::ostream& os);
+//ответ на один запрос, std::nullopt - запрос неизвестного типа. Только читает справочник, карту
+//и маршрутизатор, поэтому запросы к одному заполненному справочнику можно выполнять в нескольких потоках
+std::optional<json::Dict> ExecuteStatRequest(const stat::RequestHandler& rh, const renderer::MapObjects& m,
+                                             const routing::RoutingSettings& rt, const json::Dict& query);
+
+void ExecuteStatRequests(const head::TransportCatalogue& tc, const Query& q, const renderer::MapObjects& m,
+                         const routing::RoutingSettings& rt, std::ostream& os);
+
+void PrintRouterStats(const routing::RoutingSettings& rt, std::ostream& os);   //счетчики кэшей и сведения о расчете маршрутизатора по строке
 }//namespace reader
 }//namespace catalogue
\ No newline at end of file
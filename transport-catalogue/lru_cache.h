@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace cache {
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// Потокобезопасный кэш с вытеснением давно не использованных записей (LRU).
+// Ограничен числом записей и суммарным размером, 0 - без ограничения.
+// Размер записи передается при вставке: кэш не знает, сколько памяти занимает значение.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+    explicit LruCache(size_t max_entries, size_t max_bytes)
+    : max_entries_(max_entries)
+    , max_bytes_(max_bytes) {
+    }
+
+    // Копия значения, чтобы запись можно было вытеснить, пока значение используют
+    std::optional<Value> Find(const Key& key) {
+        std::lock_guard guard(mutex_);
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            ++stats_.misses;
+            return std::nullopt;
+        }
+        ++stats_.hits;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->value;
+    }
+
+    void Insert(const Key& key, Value value, size_t bytes) {
+        std::lock_guard guard(mutex_);
+        if (max_bytes_ > 0 && bytes > max_bytes_) {
+            return;
+        }
+        if (const auto it = index_.find(key); it != index_.end()) {
+            stats_.bytes -= it->second->bytes;
+            entries_.erase(it->second);
+            index_.erase(it);
+        }
+        entries_.push_front(Entry{key, std::move(value), bytes});
+        index_.emplace(key, entries_.begin());
+        stats_.bytes += bytes;
+        while ((max_entries_ > 0 && index_.size() > max_entries_) || (max_bytes_ > 0 && stats_.bytes > max_bytes_)) {
+            stats_.bytes -= entries_.back().bytes;
+            index_.erase(entries_.back().key);
+            entries_.pop_back();
+        }
+    }
+
+    void Clear() {
+        std::lock_guard guard(mutex_);
+        entries_.clear();
+        index_.clear();
+        stats_.bytes = 0;
+    }
+
+    CacheStats GetStats() const {
+        std::lock_guard guard(mutex_);
+        CacheStats stats = stats_;
+        stats.entries = index_.size();
+        return stats;
+    }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t bytes = 0;
+    };
+
+    const size_t max_entries_;
+    const size_t max_bytes_;
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;                                  // от недавно использованных к давним
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index_;
+    CacheStats stats_;
+};
+
+}  // namespace cache
@@ -7,15 +7,67 @@
 #include "log_duration.h"
 #include "map_renderer.h"
 #include "request_handler.h"
+#include "server.h"
+#include "socket_server.h"
 #include "svg.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <exception>
 #include <fstream>
+#include <memory>
+#include <string_view>
+#include <vector>
 
 using namespace std;
 
-int main() {
+//режимы работы:
+//  без аргументов        - ответы на stat_requests из input.json в output_result.json, карта в output_result.xml
+//  serve <путь к сокету> - справочник из input.json загружается один раз, запросы принимаются по Unix-сокету,
+//                          по сигналу SIGHUP input.json перечитывается без остановки ответов (кроме Windows)
+//  stream                - справочник из input.json, запросы построчно из stdin, ответы построчно в stdout
+int main(int argc, char* argv[]) {
+    const vector<string_view> args(argv + 1, argv + argc);
+#ifdef _WIN32
+    const bool is_server = false;                                               //Unix-сокетов и SIGHUP в Windows нет
+    const string_view modes = "[stream]"sv;
+#else
+    const bool is_server = args.size() == 2 && args[0] == "serve"sv;
+    const string_view modes = "[serve <socket path> | stream]"sv;
+#endif
+    const bool is_stream = args.size() == 1 && args[0] == "stream"sv;
+    if (!args.empty() && !is_server && !is_stream) {
+        cerr << "Usage: "sv << argv[0] << " "sv << modes << endl;
+        return 1;
+    }
+
+#ifndef _WIN32
+    if (is_server) {
+        try {
+            catalogue::server::ServeUnixSocket(string(args[1]), "input.json"s);
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+#endif
+
+    if (is_stream) {
+        //собственный буфер cin: без него нельзя узнать, есть ли еще прочитанные строки
+        ios::sync_with_stdio(false);
+        std::shared_ptr<const catalogue::server::Snapshot> snapshot;
+        try {
+            snapshot = catalogue::server::LoadSnapshot("input.json"s);
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        catalogue::server::ServeStream(std::cin, std::cout, *snapshot);
+        catalogue::reader::PrintRouterStats(snapshot->rt, cerr);
+        return 0;
+    }
+
     std::ifstream in("input.json");
     std::streambuf *cinbuf = std::cin.rdbuf();
     std::cin.rdbuf(in.rdbuf());
@@ -0,0 +1,360 @@
+#include "min_plus.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MIN_PLUS_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+
+namespace graph {
+namespace {
+using MinPlusKernel = void (*)(double, const double*, const uint32_t*, double*, uint32_t*, size_t);
+using IntMinPlusKernel = void (*)(int32_t, const int32_t*, const uint32_t*, int32_t*, uint32_t*, size_t);
+using HopsMinPlusKernel = void (*)(double, uint32_t, const double*, const uint32_t*, const uint32_t*, double*, uint32_t*, uint32_t*, size_t);
+using IntHopsMinPlusKernel = void (*)(int32_t, uint32_t, const int32_t*, const uint32_t*, const uint32_t*, int32_t*, uint32_t*, uint32_t*, size_t);
+
+constexpr int32_t INT_INFINITE_WEIGHT = std::numeric_limits<int32_t>::max();
+constexpr int32_t INT_MAX_FINITE_WEIGHT = INT_INFINITE_WEIGHT - 1;
+
+//веса неотрицательны, поэтому сумма считается в int64_t и ограничивается сверху наибольшим конечным весом
+int32_t AddSaturated(int32_t lhs, int32_t rhs) {
+    return static_cast<int32_t>(std::min<int64_t>(static_cast<int64_t>(lhs) + rhs, INT_MAX_FINITE_WEIGHT));
+}
+
+void RelaxRowScalar(double weight_from, const double* weights_through, const uint32_t* prev_edges_through,
+                    double* weights, uint32_t* prev_edges, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const double candidate_weight = weight_from + weights_through[i];
+        if (candidate_weight < weights[i]) {
+            weights[i] = candidate_weight;
+            prev_edges[i] = prev_edges_through[i];
+        }
+    }
+}
+
+void RelaxIntRowScalar(int32_t weight_from, const int32_t* weights_through, const uint32_t* prev_edges_through,
+                       int32_t* weights, uint32_t* prev_edges, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (weights_through[i] == INT_INFINITE_WEIGHT) {
+            continue;
+        }
+        const int32_t candidate_weight = AddSaturated(weight_from, weights_through[i]);
+        if (candidate_weight < weights[i]) {
+            weights[i] = candidate_weight;
+            prev_edges[i] = prev_edges_through[i];
+        }
+    }
+}
+
+//маршрут (weight, hops) лучше текущего, если легче, а при равном весе - короче по числу ребер
+template <typename Weight>
+bool IsBetterRoute(Weight weight, uint32_t hops, Weight current_weight, uint32_t current_hops) {
+    return weight < current_weight || (weight == current_weight && hops < current_hops);
+}
+
+void RelaxRowHopsScalar(double weight_from, uint32_t hops_from, const double* weights_through, const uint32_t* hops_through,
+                        const uint32_t* prev_edges_through, double* weights, uint32_t* hops, uint32_t* prev_edges, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (weights_through[i] == std::numeric_limits<double>::infinity()) {
+            continue;
+        }
+        const double candidate_weight = weight_from + weights_through[i];
+        const uint32_t candidate_hops = hops_from + hops_through[i];
+        if (IsBetterRoute(candidate_weight, candidate_hops, weights[i], hops[i])) {
+            weights[i] = candidate_weight;
+            hops[i] = candidate_hops;
+            prev_edges[i] = prev_edges_through[i];
+        }
+    }
+}
+
+void RelaxIntRowHopsScalar(int32_t weight_from, uint32_t hops_from, const int32_t* weights_through, const uint32_t* hops_through,
+                           const uint32_t* prev_edges_through, int32_t* weights, uint32_t* hops, uint32_t* prev_edges, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (weights_through[i] == INT_INFINITE_WEIGHT) {
+            continue;
+        }
+        const int32_t candidate_weight = AddSaturated(weight_from, weights_through[i]);
+        const uint32_t candidate_hops = hops_from + hops_through[i];
+        if (IsBetterRoute(candidate_weight, candidate_hops, weights[i], hops[i])) {
+            weights[i] = candidate_weight;
+            hops[i] = candidate_hops;
+            prev_edges[i] = prev_edges_through[i];
+        }
+    }
+}
+
+#ifdef MIN_PLUS_X86_DISPATCH
+__attribute__((target("sse4.1")))
+void RelaxRowSse41(double weight_from, const double* weights_through, const uint32_t* prev_edges_through,
+                   double* weights, uint32_t* prev_edges, size_t count) {
+    const __m128d from = _mm_set1_pd(weight_from);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d candidate = _mm_add_pd(from, _mm_loadu_pd(weights_through + i));
+        const __m128d current = _mm_loadu_pd(weights + i);
+        const __m128d mask = _mm_cmplt_pd(candidate, current);
+        _mm_storeu_pd(weights + i, _mm_blendv_pd(current, candidate, mask));
+
+        //маска 2 x 64 бита сжимается до 2 x 32 бит под номера ребер
+        const __m128i edge_mask = _mm_shuffle_epi32(_mm_castpd_si128(mask), _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128i current_edges = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev_edges + i));
+        const __m128i through_edges = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev_edges_through + i));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(prev_edges + i), _mm_blendv_epi8(current_edges, through_edges, edge_mask));
+    }
+    RelaxRowScalar(weight_from, weights_through + i, prev_edges_through + i, weights + i, prev_edges + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void RelaxRowAvx2(double weight_from, const double* weights_through, const uint32_t* prev_edges_through,
+                  double* weights, uint32_t* prev_edges, size_t count) {
+    const __m256d from = _mm256_set1_pd(weight_from);
+    const __m256i low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d candidate = _mm256_add_pd(from, _mm256_loadu_pd(weights_through + i));
+        const __m256d current = _mm256_loadu_pd(weights + i);
+        const __m256d mask = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+        _mm256_storeu_pd(weights + i, _mm256_blendv_pd(current, candidate, mask));
+
+        //маска 4 x 64 бита сжимается до 4 x 32 бит под номера ребер
+        const __m128i edge_mask = _mm256_castsi256_si128(
+            _mm256_permutevar8x32_epi32(_mm256_castpd_si256(mask), low_halves));
+        const __m128i current_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + i));
+        const __m128i through_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + i), _mm_blendv_epi8(current_edges, through_edges, edge_mask));
+    }
+    RelaxRowScalar(weight_from, weights_through + i, prev_edges_through + i, weights + i, prev_edges + i, count - i);
+}
+
+//сумма с INT32_MAX переполняется, но такие ячейки исключаются маской до сравнения. Сумма двух
+//конечных весов меньше 2^32 и точна как беззнаковая, поэтому беззнаковый минимум ограничивает ее наибольшим конечным весом
+__attribute__((target("sse4.1")))
+void RelaxIntRowSse41(int32_t weight_from, const int32_t* weights_through, const uint32_t* prev_edges_through,
+                      int32_t* weights, uint32_t* prev_edges, size_t count) {
+    const __m128i from = _mm_set1_epi32(weight_from);
+    const __m128i infinity = _mm_set1_epi32(INT_INFINITE_WEIGHT);
+    const __m128i max_finite = _mm_set1_epi32(INT_MAX_FINITE_WEIGHT);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i through = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights_through + i));
+        const __m128i candidate = _mm_min_epu32(_mm_add_epi32(from, through), max_finite);
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        const __m128i mask = _mm_andnot_si128(_mm_cmpeq_epi32(through, infinity), _mm_cmplt_epi32(candidate, current));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(weights + i), _mm_blendv_epi8(current, candidate, mask));
+
+        const __m128i current_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + i));
+        const __m128i through_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + i), _mm_blendv_epi8(current_edges, through_edges, mask));
+    }
+    RelaxIntRowScalar(weight_from, weights_through + i, prev_edges_through + i, weights + i, prev_edges + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void RelaxIntRowAvx2(int32_t weight_from, const int32_t* weights_through, const uint32_t* prev_edges_through,
+                     int32_t* weights, uint32_t* prev_edges, size_t count) {
+    const __m256i from = _mm256_set1_epi32(weight_from);
+    const __m256i infinity = _mm256_set1_epi32(INT_INFINITE_WEIGHT);
+    const __m256i max_finite = _mm256_set1_epi32(INT_MAX_FINITE_WEIGHT);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i through = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights_through + i));
+        const __m256i candidate = _mm256_min_epu32(_mm256_add_epi32(from, through), max_finite);
+        const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        const __m256i mask = _mm256_andnot_si256(_mm256_cmpeq_epi32(through, infinity), _mm256_cmpgt_epi32(current, candidate));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(weights + i), _mm256_blendv_epi8(current, candidate, mask));
+
+        const __m256i current_edges = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges + i));
+        const __m256i through_edges = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges_through + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(prev_edges + i), _mm256_blendv_epi8(current_edges, through_edges, mask));
+    }
+    RelaxIntRowScalar(weight_from, weights_through + i, prev_edges_through + i, weights + i, prev_edges + i, count - i);
+}
+
+//маски весов 2 x 64 бита сжимаются до 2 x 32 бит, как числа ребер и номера ребер
+__attribute__((target("sse4.1")))
+inline __m128i NarrowMask(__m128d mask) {
+    return _mm_shuffle_epi32(_mm_castpd_si128(mask), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+//маски весов 4 x 64 бита сжимаются до 4 x 32 бит
+__attribute__((target("avx2")))
+inline __m128i NarrowMask(__m256d mask) {
+    const __m256i low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(mask), low_halves));
+}
+
+//числа ребер сравниваются как int32: их меньше 2^31
+__attribute__((target("sse4.1")))
+void RelaxRowHopsSse41(double weight_from, uint32_t hops_from, const double* weights_through, const uint32_t* hops_through,
+                       const uint32_t* prev_edges_through, double* weights, uint32_t* hops, uint32_t* prev_edges, size_t count) {
+    const __m128d from = _mm_set1_pd(weight_from);
+    const __m128d infinity = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128i from_hops = _mm_set1_epi32(static_cast<int32_t>(hops_from));
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d through = _mm_loadu_pd(weights_through + i);
+        const __m128d candidate = _mm_add_pd(from, through);
+        const __m128d current = _mm_loadu_pd(weights + i);
+        const __m128i candidate_hops = _mm_add_epi32(from_hops, _mm_loadl_epi64(reinterpret_cast<const __m128i*>(hops_through + i)));
+        const __m128i current_hops = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(hops + i));
+
+        const __m128i is_less = NarrowMask(_mm_cmplt_pd(candidate, current));
+        const __m128i is_equal = NarrowMask(_mm_cmpeq_pd(candidate, current));
+        const __m128i is_finite = NarrowMask(_mm_cmpneq_pd(through, infinity));
+        const __m128i mask = _mm_and_si128(is_finite, _mm_or_si128(is_less, _mm_and_si128(is_equal, _mm_cmplt_epi32(candidate_hops, current_hops))));
+        const __m128d wide_mask = _mm_castsi128_pd(_mm_cvtepi32_epi64(mask));
+        _mm_storeu_pd(weights + i, _mm_blendv_pd(current, candidate, wide_mask));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(hops + i), _mm_blendv_epi8(current_hops, candidate_hops, mask));
+
+        const __m128i current_edges = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev_edges + i));
+        const __m128i through_edges = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev_edges_through + i));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(prev_edges + i), _mm_blendv_epi8(current_edges, through_edges, mask));
+    }
+    RelaxRowHopsScalar(weight_from, hops_from, weights_through + i, hops_through + i, prev_edges_through + i,
+                       weights + i, hops + i, prev_edges + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void RelaxRowHopsAvx2(double weight_from, uint32_t hops_from, const double* weights_through, const uint32_t* hops_through,
+                      const uint32_t* prev_edges_through, double* weights, uint32_t* hops, uint32_t* prev_edges, size_t count) {
+    const __m256d from = _mm256_set1_pd(weight_from);
+    const __m256d infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128i from_hops = _mm_set1_epi32(static_cast<int32_t>(hops_from));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d through = _mm256_loadu_pd(weights_through + i);
+        const __m256d candidate = _mm256_add_pd(from, through);
+        const __m256d current = _mm256_loadu_pd(weights + i);
+        const __m128i candidate_hops = _mm_add_epi32(from_hops, _mm_loadu_si128(reinterpret_cast<const __m128i*>(hops_through + i)));
+        const __m128i current_hops = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hops + i));
+
+        const __m128i is_less = NarrowMask(_mm256_cmp_pd(candidate, current, _CMP_LT_OQ));
+        const __m128i is_equal = NarrowMask(_mm256_cmp_pd(candidate, current, _CMP_EQ_OQ));
+        const __m128i is_finite = NarrowMask(_mm256_cmp_pd(through, infinity, _CMP_NEQ_OQ));
+        const __m128i mask = _mm_and_si128(is_finite, _mm_or_si128(is_less, _mm_and_si128(is_equal, _mm_cmplt_epi32(candidate_hops, current_hops))));
+        const __m256d wide_mask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(mask));
+        _mm256_storeu_pd(weights + i, _mm256_blendv_pd(current, candidate, wide_mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hops + i), _mm_blendv_epi8(current_hops, candidate_hops, mask));
+
+        const __m128i current_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + i));
+        const __m128i through_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + i), _mm_blendv_epi8(current_edges, through_edges, mask));
+    }
+    RelaxRowHopsScalar(weight_from, hops_from, weights_through + i, hops_through + i, prev_edges_through + i,
+                       weights + i, hops + i, prev_edges + i, count - i);
+}
+
+//сумма с INT32_MAX переполняется, но такие ячейки исключаются маской до сравнения. Сумма двух
+//конечных весов меньше 2^32 и точна как беззнаковая, поэтому беззнаковый минимум ограничивает ее наибольшим конечным весом
+__attribute__((target("sse4.1")))
+void RelaxIntRowHopsSse41(int32_t weight_from, uint32_t hops_from, const int32_t* weights_through, const uint32_t* hops_through,
+                          const uint32_t* prev_edges_through, int32_t* weights, uint32_t* hops, uint32_t* prev_edges, size_t count) {
+    const __m128i from = _mm_set1_epi32(weight_from);
+    const __m128i from_hops = _mm_set1_epi32(static_cast<int32_t>(hops_from));
+    const __m128i infinity = _mm_set1_epi32(INT_INFINITE_WEIGHT);
+    const __m128i max_finite = _mm_set1_epi32(INT_MAX_FINITE_WEIGHT);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i through = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights_through + i));
+        const __m128i candidate = _mm_min_epu32(_mm_add_epi32(from, through), max_finite);
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        const __m128i candidate_hops = _mm_add_epi32(from_hops, _mm_loadu_si128(reinterpret_cast<const __m128i*>(hops_through + i)));
+        const __m128i current_hops = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hops + i));
+        const __m128i is_better = _mm_or_si128(_mm_cmplt_epi32(candidate, current),
+                                               _mm_and_si128(_mm_cmpeq_epi32(candidate, current), _mm_cmplt_epi32(candidate_hops, current_hops)));
+        const __m128i mask = _mm_andnot_si128(_mm_cmpeq_epi32(through, infinity), is_better);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(weights + i), _mm_blendv_epi8(current, candidate, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hops + i), _mm_blendv_epi8(current_hops, candidate_hops, mask));
+
+        const __m128i current_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + i));
+        const __m128i through_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + i), _mm_blendv_epi8(current_edges, through_edges, mask));
+    }
+    RelaxIntRowHopsScalar(weight_from, hops_from, weights_through + i, hops_through + i, prev_edges_through + i,
+                          weights + i, hops + i, prev_edges + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void RelaxIntRowHopsAvx2(int32_t weight_from, uint32_t hops_from, const int32_t* weights_through, const uint32_t* hops_through,
+                         const uint32_t* prev_edges_through, int32_t* weights, uint32_t* hops, uint32_t* prev_edges, size_t count) {
+    const __m256i from = _mm256_set1_epi32(weight_from);
+    const __m256i from_hops = _mm256_set1_epi32(static_cast<int32_t>(hops_from));
+    const __m256i infinity = _mm256_set1_epi32(INT_INFINITE_WEIGHT);
+    const __m256i max_finite = _mm256_set1_epi32(INT_MAX_FINITE_WEIGHT);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i through = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights_through + i));
+        const __m256i candidate = _mm256_min_epu32(_mm256_add_epi32(from, through), max_finite);
+        const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        const __m256i candidate_hops = _mm256_add_epi32(from_hops, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hops_through + i)));
+        const __m256i current_hops = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hops + i));
+        const __m256i is_better = _mm256_or_si256(_mm256_cmpgt_epi32(current, candidate),
+                                                  _mm256_and_si256(_mm256_cmpeq_epi32(candidate, current),
+                                                                   _mm256_cmpgt_epi32(current_hops, candidate_hops)));
+        const __m256i mask = _mm256_andnot_si256(_mm256_cmpeq_epi32(through, infinity), is_better);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(weights + i), _mm256_blendv_epi8(current, candidate, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hops + i), _mm256_blendv_epi8(current_hops, candidate_hops, mask));
+
+        const __m256i current_edges = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges + i));
+        const __m256i through_edges = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges_through + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(prev_edges + i), _mm256_blendv_epi8(current_edges, through_edges, mask));
+    }
+    RelaxIntRowHopsScalar(weight_from, hops_from, weights_through + i, hops_through + i, prev_edges_through + i,
+                          weights + i, hops + i, prev_edges + i, count - i);
+}
+#endif
+
+struct KernelChoice {
+    MinPlusKernel kernel;
+    IntMinPlusKernel int_kernel;
+    HopsMinPlusKernel hops_kernel;
+    IntHopsMinPlusKernel int_hops_kernel;
+    const char* name;
+};
+
+KernelChoice ChooseKernel() {
+#ifdef MIN_PLUS_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {RelaxRowAvx2, RelaxIntRowAvx2, RelaxRowHopsAvx2, RelaxIntRowHopsAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return {RelaxRowSse41, RelaxIntRowSse41, RelaxRowHopsSse41, RelaxIntRowHopsSse41, "sse4.1"};
+    }
+#endif
+    return {RelaxRowScalar, RelaxIntRowScalar, RelaxRowHopsScalar, RelaxIntRowHopsScalar, "scalar"};
+}
+
+const KernelChoice& GetKernel() {
+    static const KernelChoice kernel = ChooseKernel();
+    return kernel;
+}
+}// namespace
+
+void RelaxRowMinPlus(double weight_from, const double* weights_through, const uint32_t* prev_edges_through,
+                     double* weights, uint32_t* prev_edges, size_t count) {
+    GetKernel().kernel(weight_from, weights_through, prev_edges_through, weights, prev_edges, count);
+}
+
+void RelaxRowMinPlus(int32_t weight_from, const int32_t* weights_through, const uint32_t* prev_edges_through,
+                     int32_t* weights, uint32_t* prev_edges, size_t count) {
+    GetKernel().int_kernel(weight_from, weights_through, prev_edges_through, weights, prev_edges, count);
+}
+
+void RelaxRowMinPlus(double weight_from, uint32_t hops_from, const double* weights_through, const uint32_t* hops_through,
+                     const uint32_t* prev_edges_through, double* weights, uint32_t* hops, uint32_t* prev_edges, size_t count) {
+    GetKernel().hops_kernel(weight_from, hops_from, weights_through, hops_through, prev_edges_through, weights, hops, prev_edges, count);
+}
+
+void RelaxRowMinPlus(int32_t weight_from, uint32_t hops_from, const int32_t* weights_through, const uint32_t* hops_through,
+                     const uint32_t* prev_edges_through, int32_t* weights, uint32_t* hops, uint32_t* prev_edges, size_t count) {
+    GetKernel().int_hops_kernel(weight_from, hops_from, weights_through, hops_through, prev_edges_through, weights, hops, prev_edges, count);
+}
+
+const char* GetMinPlusKernelName() {
+    return GetKernel().name;
+}
+}// namespace graph
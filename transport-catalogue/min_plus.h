@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace graph {
+
+// Строка релаксации min-plus для плоской таблицы маршрутов:
+// для каждого i из [0, count), если weight_from + weights_through[i] < weights[i],
+// записывает сумму в weights[i] и prev_edges_through[i] в prev_edges[i].
+// Отсутствие маршрута обозначается +inf. Реализация (AVX2, SSE4.1 или скалярная)
+// выбирается при первом вызове по возможностям процессора; результат у всех одинаков.
+void RelaxRowMinPlus(double weight_from, const double* weights_through, const uint32_t* prev_edges_through,
+                     double* weights, uint32_t* prev_edges, size_t count);
+
+// То же для целых весов: отсутствие маршрута обозначается INT32_MAX,
+// такие ячейки weights_through пропускаются без сложения; сумма конечных весов
+// не переполняется, а ограничивается сверху значением INT32_MAX - 1
+void RelaxRowMinPlus(int32_t weight_from, const int32_t* weights_through, const uint32_t* prev_edges_through,
+                     int32_t* weights, uint32_t* prev_edges, size_t count);
+
+// Релаксация для графов с ребрами нулевого веса: маршрут через промежуточную вершину имеет
+// hops_from + hops_through[i] ребер и записывается также и при равном весе, если ребер в нем меньше.
+// Так вес любого цикла с учетом числа ребер положителен, и цепочки последних ребер не зацикливаются.
+void RelaxRowMinPlus(double weight_from, uint32_t hops_from, const double* weights_through, const uint32_t* hops_through,
+                     const uint32_t* prev_edges_through, double* weights, uint32_t* hops, uint32_t* prev_edges, size_t count);
+
+void RelaxRowMinPlus(int32_t weight_from, uint32_t hops_from, const int32_t* weights_through, const uint32_t* hops_through,
+                     const uint32_t* prev_edges_through, int32_t* weights, uint32_t* hops, uint32_t* prev_edges, size_t count);
+
+// Название выбранной реализации: "avx2", "sse4.1" или "scalar"
+const char* GetMinPlusKernelName();
+
+}  // namespace graph
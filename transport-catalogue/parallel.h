@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Количество потоков из настроек: 0 означает все доступные ядра
+inline size_t ResolveThreadCount(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    return std::max<size_t>(thread_count, 1);
+}
+
+// Отмечает поток как один из нескольких рабочих потоков на время своей жизни.
+// Вложенный ForEachIndex в таком потоке выполняется последовательно: иначе, например,
+// stat_threads потоков ответов запустили бы по router_threads потоков на матрицу маршрутов
+class WorkerScope {
+public:
+    WorkerScope() : was_worker_(IsWorker()) {
+        IsWorker() = true;
+    }
+
+    ~WorkerScope() {
+        IsWorker() = was_worker_;
+    }
+
+    WorkerScope(const WorkerScope&) = delete;
+    WorkerScope& operator=(const WorkerScope&) = delete;
+
+    static bool& IsWorker() {
+        thread_local bool is_worker = false;
+        return is_worker;
+    }
+
+private:
+    bool was_worker_;
+};
+
+// Вызывает function(index) для каждого index из [0, count) в thread_count потоках.
+// Индексы раздаются по одному, поэтому долгие задачи не задерживают остальные потоки.
+// Первое выброшенное исключение передается вызывающему после завершения всех потоков.
+// Вызов из рабочего потока другого ForEachIndex выполняется последовательно (см. WorkerScope)
+template <typename Function>
+void ForEachIndex(size_t count, size_t thread_count, Function function) {
+    const size_t worker_count = WorkerScope::IsWorker() ? 1 : std::min(ResolveThreadCount(thread_count), count);
+    if (worker_count <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            function(index);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next_index{0};
+    std::atomic<bool> is_failed{false};
+    std::exception_ptr error;
+    const auto worker = [&]() {
+        const WorkerScope scope;
+        try {
+            for (size_t index = next_index++; index < count && !is_failed; index = next_index++) {
+                function(index);
+            }
+        } catch (...) {
+            if (!is_failed.exchange(true)) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(worker_count - 1);
+    for (size_t i = 1; i < worker_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace parallel
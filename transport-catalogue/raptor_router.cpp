@@ -0,0 +1,190 @@
+#include "raptor_router.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+namespace catalogue {
+namespace routing {
+RaptorRouter::RaptorRouter(const stat::RequestHandler& rh, int bus_wait_time, double bus_velocity)
+    : bus_wait_time_(bus_wait_time)
+    , bus_velocity_(bus_velocity) {
+    //маршруты обходятся по названиям, как в BuildGraph, чтобы при равном времени ответ не зависел от адресов в памяти
+    const std::unordered_set<const Bus*> bus_set = rh.GetBusesPtr();
+    std::vector<const Bus*> all_buses(bus_set.begin(), bus_set.end());
+    std::sort(all_buses.begin(), all_buses.end(), [](const Bus* lhs, const Bus* rhs) {
+        return lhs->GetBus() < rhs->GetBus();
+    });
+    for (const Bus* bus_ptr : all_buses) {
+        const std::vector<const Stop*> all_stops = bus_ptr->GetBusAndStops();
+        if (all_stops.empty()) {
+            continue;
+        }
+        if (bus_ptr->IsRing()) {
+            AddSegment(rh, bus_ptr, all_stops.begin(), all_stops.end());
+        } else {
+            //прямое и обратное направления - разные участки, разворот на конечной требует новой посадки
+            auto middle = std::next(all_stops.begin(), all_stops.size() / 2);
+            AddSegment(rh, bus_ptr, all_stops.begin(), std::next(middle));
+            AddSegment(rh, bus_ptr, middle, all_stops.end());
+        }
+    }
+}
+
+void RaptorRouter::AddSegment(const stat::RequestHandler& rh, const Bus* bus_ptr, std::vector<const Stop*>::const_iterator begin,
+                              std::vector<const Stop*>::const_iterator end) {
+    if (std::distance(begin, end) < 2) {
+        return;
+    }
+    const size_t segment_id = segments_.size();
+    Segment segment;
+    segment.bus = bus_ptr;
+    int64_t distance = 0;
+    for (auto it = begin; it != end; ++it) {
+        if (it != begin) {
+            distance += rh.ComputeDistance(*std::prev(it), *it);
+        }
+        const size_t stop = AddStop(*it);
+        stop_segments_[stop].push_back({segment_id, segment.stops.size()});
+        segment.stops.push_back(stop);
+        segment.distances.push_back(distance);
+    }
+    segments_.push_back(std::move(segment));
+}
+
+size_t RaptorRouter::AddStop(const Stop* stop) {
+    auto [it, is_inserted] = stop_index_.insert({stop, stops_.size()});
+    if (is_inserted) {
+        stops_.push_back(stop);
+        stop_segments_.emplace_back();
+    }
+    return it->second;
+}
+
+size_t RaptorRouter::GetStopIndex(const Stop* stop) const {
+    auto it = stop_index_.find(stop);
+    return it == stop_index_.end() ? NONE : it->second;
+}
+
+double RaptorRouter::ComputeRideTime(const Segment& segment, size_t board_position, size_t alight_position, const SearchData& data) const {
+    const int road_distance = static_cast<int>(segment.distances[alight_position] - segment.distances[board_position]);
+    return ComputeTimeForEdge(data.bus_wait_time, data.bus_velocity, road_distance);
+}
+
+void RaptorRouter::ScanSegment(size_t segment_id, size_t round, size_t target, SearchData& data) const {
+    const Segment& segment = segments_[segment_id];
+    const std::vector<Label>& previous = data.rounds[round - 1];
+    std::vector<Label>& current = data.rounds[round];
+
+    size_t board_position = NONE;
+    double board_time = INFINITE_TIME;
+    for (size_t position = data.first_positions[segment_id]; position < segment.stops.size(); ++position) {
+        const size_t stop = segment.stops[position];
+        if (board_position != NONE) {
+            const double time = board_time + ComputeRideTime(segment, board_position, position, data);
+            if (time < std::min(data.best_times[stop], data.best_times[target])) {
+                current[stop] = {time, segment_id, board_position, position};
+                data.best_times[stop] = time;
+                if (!data.is_marked[stop]) {
+                    data.is_marked[stop] = true;
+                    data.marked_stops.push_back(stop);
+                }
+            }
+        }
+        //пересаживаемся на этот автобус позже, если к остановке можно приехать раньше, чем на нем
+        const double arrival_time = previous[stop].time;
+        if (arrival_time < INFINITE_TIME
+            && (board_position == NONE
+                || arrival_time < board_time + ComputeRideTime(segment, board_position, position, data) - data.bus_wait_time)) {
+            board_position = position;
+            board_time = arrival_time;
+        }
+    }
+}
+
+RaptorJourney RaptorRouter::MakeJourney(size_t target, size_t round, const SearchData& data) const {
+    RaptorJourney journey;
+    journey.total_time_ = data.rounds[round][target].time;
+    size_t stop = target;
+    for (; round > 0; --round) {
+        const Label& label = data.rounds[round][stop];
+        const Segment& segment = segments_[label.segment];
+        const size_t board_stop = segment.stops[label.board_position];
+        RaptorLeg leg;
+        leg.board_stop_ = stops_[board_stop];
+        leg.bus_ = segment.bus;
+        leg.span_count_ = static_cast<int>(label.alight_position - label.board_position);
+        leg.time_ = ComputeRideTime(segment, label.board_position, label.alight_position, data) - data.bus_wait_time;
+        journey.legs_.push_back(leg);
+        stop = board_stop;
+    }
+    std::reverse(journey.legs_.begin(), journey.legs_.end());
+    return journey;
+}
+
+std::optional<RaptorJourney> RaptorRouter::BuildRoute(const Stop* from, const Stop* to) const {
+    return BuildRoute(from, to, bus_wait_time_, bus_velocity_);
+}
+
+std::optional<RaptorJourney> RaptorRouter::BuildRoute(const Stop* from, const Stop* to, int bus_wait_time, double bus_velocity) const {
+    const size_t source = GetStopIndex(from);
+    const size_t target = GetStopIndex(to);
+    if (source == NONE || target == NONE) {
+        return std::nullopt;
+    }
+
+    static thread_local SearchData data;
+    const size_t stop_count = stops_.size();
+    data.rounds.resize(1);
+    data.rounds[0].assign(stop_count, Label{});
+    data.best_times.assign(stop_count, INFINITE_TIME);
+    data.is_marked.assign(stop_count, false);
+    data.first_positions.assign(segments_.size(), NONE);
+    data.marked_stops.clear();
+    data.marked_segments.clear();
+    data.bus_wait_time = bus_wait_time;
+    data.bus_velocity = bus_velocity;
+
+    data.rounds[0][source].time = 0.0;
+    data.best_times[source] = 0.0;
+    data.marked_stops.push_back(source);
+
+    size_t best_round = 0;
+    for (size_t round = 1; !data.marked_stops.empty(); ++round) {
+        //собираем участки через отмеченные остановки и самую раннюю позицию посадки на каждом
+        for (const size_t stop : data.marked_stops) {
+            data.is_marked[stop] = false;
+            for (const auto& [segment_id, position] : stop_segments_[stop]) {
+                size_t& first_position = data.first_positions[segment_id];
+                if (first_position == NONE) {
+                    data.marked_segments.push_back(segment_id);
+                }
+                first_position = std::min(first_position, position);
+            }
+        }
+        data.marked_stops.clear();
+
+        if (data.rounds.size() <= round) {
+            data.rounds.emplace_back();
+        }
+        data.rounds[round].assign(stop_count, Label{});
+
+        for (const size_t segment_id : data.marked_segments) {
+            ScanSegment(segment_id, round, target, data);
+            data.first_positions[segment_id] = NONE;
+        }
+        data.marked_segments.clear();
+
+        if (data.rounds[round][target].time < INFINITE_TIME) {
+            best_round = round;
+        }
+    }
+
+    if (data.best_times[target] == INFINITE_TIME) {
+        return std::nullopt;
+    }
+    return MakeJourney(target, best_round, data);
+}
+}// namespace routing
+}// namespace catalogue
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "domain.h"
+#include "request_handler.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace catalogue {
+namespace routing {
+using Stop = domain::Stop;
+using Bus = domain::Bus;
+
+//поездка на одном автобусе: посадка на остановке board_stop_ и проезд span_count_ остановок
+struct RaptorLeg {
+    const Stop* board_stop_ = nullptr;
+    const Bus* bus_ = nullptr;
+    int span_count_ = 0;
+    double time_ = 0.0;                                                             //время в пути без ожидания
+};
+
+struct RaptorJourney {
+    double total_time_ = 0.0;
+    std::vector<RaptorLeg> legs_;
+};
+
+//маршрутизатор по раундам (RAPTOR): раунд k находит лучшие маршруты не более чем с k поездками,
+//просматривая последовательности остановок автобусов, без построения графа всех пар остановок
+class RaptorRouter {
+public:
+    explicit RaptorRouter(const stat::RequestHandler& rh, int bus_wait_time, double bus_velocity);
+
+    std::optional<RaptorJourney> BuildRoute(const Stop* from, const Stop* to) const;
+
+    //маршрут при других времени ожидания и скорости автобуса, чем заданы при создании
+    std::optional<RaptorJourney> BuildRoute(const Stop* from, const Stop* to, int bus_wait_time, double bus_velocity) const;
+
+private:
+    static constexpr double INFINITE_TIME = std::numeric_limits<double>::infinity();
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    //участок маршрута, по которому можно ехать без пересадки: кольцевой маршрут целиком
+    //или одно направление некольцевого маршрута
+    struct Segment {
+        const Bus* bus = nullptr;
+        std::vector<size_t> stops;                                                  //номера остановок по порядку
+        std::vector<int64_t> distances;                                             //расстояние от начала участка до остановки
+    };
+
+    struct SegmentStop {
+        size_t segment;
+        size_t position;
+    };
+
+    //метка остановки в раунде: время прибытия и поездка, которой она достигнута
+    struct Label {
+        double time = INFINITE_TIME;
+        size_t segment = NONE;
+        size_t board_position = NONE;
+        size_t alight_position = NONE;
+    };
+
+    struct SearchData {
+        std::vector<std::vector<Label>> rounds;
+        std::vector<double> best_times;
+        std::vector<size_t> marked_stops;
+        std::vector<bool> is_marked;
+        std::vector<size_t> first_positions;                                        //самая ранняя отмеченная позиция на участке
+        std::vector<size_t> marked_segments;
+        int bus_wait_time = 0;                                                      //параметры текущего запроса
+        double bus_velocity = 0.0;
+    };
+
+    void AddSegment(const stat::RequestHandler& rh, const Bus* bus_ptr, std::vector<const Stop*>::const_iterator begin,
+                    std::vector<const Stop*>::const_iterator end);
+
+    size_t AddStop(const Stop* stop);
+
+    size_t GetStopIndex(const Stop* stop) const;
+
+    double ComputeRideTime(const Segment& segment, size_t board_position, size_t alight_position, const SearchData& data) const;
+
+    void ScanSegment(size_t segment_id, size_t round, size_t target, SearchData& data) const;
+
+    RaptorJourney MakeJourney(size_t target, size_t round, const SearchData& data) const;
+
+    int bus_wait_time_ = 0;
+    double bus_velocity_ = 0.0;
+    std::vector<const Stop*> stops_;                                                //остановки, через которые проходят маршруты, по номерам
+    std::unordered_map<const Stop*, size_t> stop_index_;                            //словарь указатель на остановку - номер
+    std::vector<Segment> segments_;
+    std::vector<std::vector<SegmentStop>> stop_segments_;                           //участки, проходящие через остановку
+};
+}// namespace routing
+}// namespace catalogue
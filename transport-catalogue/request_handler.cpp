@@ -41,27 +41,15 @@ std::unordered_set<const Bus*> RequestHandler::GetBusesPtr() const {
     return result;
 }
 
+//поиск без исключений: запросы с неизвестными названиями часты и выполняются в нескольких потоках
 const Stop* RequestHandler::FindStop(const std::string_view stop) const noexcept {
-    const Stop* stop_ptr = nullptr;
-    try {
-        stop_ptr = GetStopPtr(stop);
-    }
-    catch (const std::invalid_argument &e) {
-        return stop_ptr;
-    }
-    return stop_ptr;
+    auto it_stop = db_.stopname_to_stop_.find(stop);
+    return it_stop == db_.stopname_to_stop_.end() ? nullptr : it_stop->second;
 }
 
 const Bus* RequestHandler::FindBus(const std::string_view bus) const noexcept {
-    const Bus* bus_ptr = nullptr;
-    try {
-        bus_ptr = GetBusPtr(bus);
-    }
-    catch (const std::invalid_argument &e) {
-        return bus_ptr;
-    }
-
-    return bus_ptr;
+    auto it_bus = db_.busname_to_bus_.find(bus);
+    return it_bus == db_.busname_to_bus_.end() ? nullptr : it_bus->second;
 }
 
 const Stop& RequestHandler::GetStopIndex(const std::string_view stop) const {
@@ -30,6 +30,12 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Таблицы маршрутов в плоском виде, как у FlatRouter: вес и последнее ребро маршрута from -> to
+    // в ячейке from * V + to, при отсутствии маршрута или ребра - no_route_weight и no_edge
+    template <typename PackedEdgeId>
+    void FillFlatTables(Weight no_route_weight, PackedEdgeId no_edge,
+                        std::vector<Weight>& weights, std::vector<PackedEdgeId>& prev_edges) const;
+
 private:
     struct RouteInternalData {
         Weight weight;
@@ -115,4 +121,23 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
     return RouteInfo{weight, std::move(edges)};
 }
 
+template <typename Weight>
+template <typename PackedEdgeId>
+void Router<Weight>::FillFlatTables(Weight no_route_weight, PackedEdgeId no_edge,
+                                    std::vector<Weight>& weights, std::vector<PackedEdgeId>& prev_edges) const {
+    const size_t vertex_count = routes_internal_data_.size();
+    weights.assign(vertex_count * vertex_count, no_route_weight);
+    prev_edges.assign(vertex_count * vertex_count, no_edge);
+    for (VertexId from = 0; from < vertex_count; ++from) {
+        for (VertexId to = 0; to < vertex_count; ++to) {
+            if (const auto& route_internal_data = routes_internal_data_[from][to]) {
+                weights[from * vertex_count + to] = route_internal_data->weight;
+                if (route_internal_data->prev_edge) {
+                    prev_edges[from * vertex_count + to] = static_cast<PackedEdgeId>(*route_internal_data->prev_edge);
+                }
+            }
+        }
+    }
+}
+
 }  // namespace graph
\ No newline at end of file
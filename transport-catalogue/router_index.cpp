@@ -0,0 +1,460 @@
+#include "router_index.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace catalogue {
+namespace routing {
+namespace {
+using FlatRouter = graph::FlatRouter<Weight>;
+using AllPairsRouter = graph::Router<Weight>;
+using HierarchyRouter = graph::ContractionHierarchyRouter<Weight>;
+
+constexpr char INDEX_MAGIC[8] = {'T', 'C', 'R', 'I', 'N', 'D', 'E', 'X'};
+constexpr uint32_t INDEX_VERSION = 5;
+constexpr uint64_t NO_NAME = std::numeric_limits<uint64_t>::max();
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t router_type;
+    uint32_t weight_size;                                                           //тип весов, с которым собрана программа
+    uint32_t weight_units_per_minute;
+    uint64_t input_hash;
+    uint64_t vertex_count;
+    uint64_t edge_count;
+    uint64_t bus_count;
+    uint64_t names_size;                                                            //размер блока названий с выравниванием
+    uint64_t has_table;                                                             //сохранена ли таблица всех маршрутов
+    uint64_t shortcut_count;                                                        //сокращения иерархии
+    uint64_t forward_arc_count;                                                     //дуги вверх по иерархии
+    uint64_t backward_arc_count;
+};
+
+struct NameRecord {
+    uint64_t begin;                                                                 //смещение в блоке названий или NO_NAME
+    uint64_t length;
+};
+
+struct EdgeRecord {
+    uint32_t from;
+    uint32_t to;
+    uint32_t bus;                                                                   //номер названия маршрута
+    int32_t span_count;
+    double weight;                                                                  //вес ребра графа, точно представимый в double
+    int32_t road_distance;
+    int32_t kind;                                                                   //вид ребра EdgeKind
+};
+
+//сокращение иерархии: дочерние дуги - номера ребер графа или более ранних сокращений
+struct ShortcutRecord {
+    uint32_t from;
+    uint32_t to;
+    uint32_t first_child;
+    uint32_t second_child;
+    double weight;
+};
+
+struct VertexRecord {
+    NameRecord name;                                                                //название остановки вершины
+    uint64_t is_stop_vertex;                                                        //вершина самой остановки, а не места в автобусе
+};
+
+uint64_t AlignSize(uint64_t size) {
+    return (size + 7) / 8 * 8;
+}
+
+//расположение разделов файла после заголовка
+struct IndexLayout {
+    explicit IndexLayout(const IndexHeader& header) {
+        edges = sizeof(IndexHeader);
+        vertex_names = edges + header.edge_count * sizeof(EdgeRecord);
+        bus_names = vertex_names + header.vertex_count * sizeof(VertexRecord);
+        names = bus_names + header.bus_count * sizeof(NameRecord);
+        weights = names + header.names_size;
+        const uint64_t cell_count = header.has_table ? header.vertex_count * header.vertex_count : 0;
+        prev_edges = weights + AlignSize(cell_count * sizeof(Weight));
+        shortcuts = prev_edges + AlignSize(cell_count * sizeof(FlatRouter::PackedEdgeId));
+        forward_arcs = shortcuts + header.shortcut_count * sizeof(ShortcutRecord);
+        backward_arcs = forward_arcs + AlignSize(header.forward_arc_count * sizeof(uint32_t));
+        end = backward_arcs + AlignSize(header.backward_arc_count * sizeof(uint32_t));
+    }
+
+    uint64_t edges;
+    uint64_t vertex_names;
+    uint64_t bus_names;
+    uint64_t names;
+    uint64_t weights;
+    uint64_t prev_edges;
+    uint64_t shortcuts;
+    uint64_t forward_arcs;
+    uint64_t backward_arcs;
+    uint64_t end;
+};
+
+//размеры из заголовка не больше самого файла, поэтому расчет смещений в IndexLayout не переполнится
+bool IsHeaderBounded(const IndexHeader& header, uint64_t file_size) {
+    if (header.vertex_count > file_size || header.edge_count > file_size
+        || header.bus_count > file_size || header.names_size > file_size || header.shortcut_count > file_size
+        || header.forward_arc_count > file_size || header.backward_arc_count > file_size) {
+        return false;
+    }
+    return !header.has_table || header.vertex_count == 0 || header.vertex_count <= file_size / header.vertex_count;
+}
+
+//таблица из файла проверяется целиком: у пустого и отсутствующего маршрутов нет последнего ребра,
+//у остальных оно есть и ведет в конечную вершину маршрута, а вес не отрицателен. Тогда BuildRoute
+//не выйдет за пределы графа, а цепочку с циклом прервет по числу ребер
+bool IsTableConsistent(const IndexHeader& header, const EdgeRecord* edges, const Weight* weights,
+                       const FlatRouter::PackedEdgeId* prev_edges) {
+    const size_t vertex_count = header.vertex_count;
+    for (size_t from = 0; from < vertex_count; ++from) {
+        for (size_t to = 0; to < vertex_count; ++to) {
+            const Weight weight = weights[from * vertex_count + to];
+            const FlatRouter::PackedEdgeId prev_edge = prev_edges[from * vertex_count + to];
+            if (from == to) {
+                if (weight != Weight{} || prev_edge != FlatRouter::NO_EDGE) {
+                    return false;
+                }
+            } else if (weight == FlatRouter::INFINITE_WEIGHT) {
+                if (prev_edge != FlatRouter::NO_EDGE) {
+                    return false;
+                }
+            } else if (!(weight >= Weight{}) || prev_edge >= header.edge_count || edges[prev_edge].to != to) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+class NamesBuilder {
+public:
+    NameRecord Add(std::string_view name) {
+        NameRecord record{names_.size(), name.size()};
+        names_.append(name);
+        return record;
+    }
+
+    std::string Build() {
+        names_.resize(AlignSize(names_.size()), '\0');
+        return names_;
+    }
+
+private:
+    std::string names_;
+};
+
+template <typename T>
+void WriteArray(std::ostream& out, const T* data, size_t count) {
+    out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+template <typename T>
+void WritePadding(std::ostream& out, uint64_t count) {
+    out.write("\0\0\0\0\0\0\0", AlignSize(count * sizeof(T)) - count * sizeof(T));
+}
+
+template <typename T>
+const T* GetArray(const MappedFile& file, uint64_t offset) {
+    return reinterpret_cast<const T*>(file.GetData() + offset);
+}
+
+std::string_view GetName(const MappedFile& file, const IndexLayout& layout, const NameRecord& record) {
+    return {file.GetData() + layout.names + record.begin, record.length};
+}
+}// namespace
+
+#ifndef _WIN32
+MappedFile::MappedFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map " + path);
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+#else
+MappedFile::MappedFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() = default;
+#endif
+
+const char* MappedFile::GetData() const {
+    return data_;
+}
+
+size_t MappedFile::GetSize() const {
+    return size_;
+}
+
+void SaveRouterIndex(const RoutingSettings& rt, uint64_t input_hash) {
+    const size_t vertex_count = rt.graph_.GetVertexCount();
+    const size_t edge_count = rt.graph_.GetEdgeCount();
+
+    //таблицы всех маршрутов: у FlatRouter они уже плоские, Router переводится в тот же вид
+    //и после загрузки отвечает через FlatRouter теми же маршрутами
+    const Weight* table_weights = nullptr;
+    const FlatRouter::PackedEdgeId* table_prev_edges = nullptr;
+    std::vector<Weight> weights;
+    std::vector<FlatRouter::PackedEdgeId> prev_edges;
+    if (const auto* flat_router = dynamic_cast<const RouteEngineImpl<FlatRouter>*>(rt.router_.get())) {
+        table_weights = flat_router->GetRouter().GetWeights();
+        table_prev_edges = flat_router->GetRouter().GetPrevEdges();
+    } else if (const auto* all_pairs_router = dynamic_cast<const RouteEngineImpl<AllPairsRouter>*>(rt.router_.get());
+               all_pairs_router && edge_count < FlatRouter::NO_EDGE) {
+        all_pairs_router->GetRouter().FillFlatTables(FlatRouter::INFINITE_WEIGHT, FlatRouter::NO_EDGE, weights, prev_edges);
+        table_weights = weights.data();
+        table_prev_edges = prev_edges.data();
+    }
+
+    //у иерархии сохраняются сокращения и дуги вверх, исходные дуги - это ребра графа
+    std::vector<ShortcutRecord> shortcuts;
+    std::vector<uint32_t> forward_arcs;
+    std::vector<uint32_t> backward_arcs;
+    if (const auto* hierarchy_router = dynamic_cast<const RouteEngineImpl<HierarchyRouter>*>(rt.router_.get())) {
+        const HierarchyRouter& router = hierarchy_router->GetRouter();
+        const auto& arcs = router.GetArcs();
+        if (arcs.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Too many arcs in the contraction hierarchy");
+        }
+        for (size_t arc_id = edge_count; arc_id < arcs.size(); ++arc_id) {
+            const auto& arc = arcs[arc_id];
+            shortcuts.push_back(ShortcutRecord{static_cast<uint32_t>(arc.from), static_cast<uint32_t>(arc.to),
+                                               static_cast<uint32_t>(arc.first_child), static_cast<uint32_t>(arc.second_child),
+                                               static_cast<double>(arc.weight)});
+        }
+        forward_arcs.assign(router.GetForwardArcIds().begin(), router.GetForwardArcIds().end());
+        backward_arcs.assign(router.GetBackwardArcIds().begin(), router.GetBackwardArcIds().end());
+    }
+
+    NamesBuilder names;
+    std::vector<VertexRecord> vertex_names(vertex_count, VertexRecord{NameRecord{NO_NAME, 0}, 0});
+    for (size_t vertex_id = 0; vertex_id < vertex_count; ++vertex_id) {
+        if (const Stop* stop_ptr = rt.vertex_id_to_stops_[vertex_id]) {
+            vertex_names[vertex_id] = VertexRecord{names.Add(stop_ptr->GetStop()), stop_ptr->GetVertexId() == vertex_id};
+        }
+    }
+
+    std::unordered_map<const Bus*, uint32_t> bus_ids;
+    std::vector<NameRecord> bus_names;
+    std::vector<EdgeRecord> edges(edge_count);
+    for (graph::EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        const auto& edge = rt.graph_.GetEdge(edge_id);
+        const EdgeInfo& edge_info = rt.edges_info_[edge_id];
+        auto [it, is_inserted] = bus_ids.insert({edge_info.bus_, static_cast<uint32_t>(bus_names.size())});
+        if (is_inserted) {
+            bus_names.push_back(names.Add(edge_info.bus_->GetBus()));
+        }
+        edges[edge_id] = EdgeRecord{static_cast<uint32_t>(edge.from), static_cast<uint32_t>(edge.to),
+                                    it->second, edge_info.span_count_, static_cast<double>(edge.weight), edge_info.road_distance_,
+                                    static_cast<int32_t>(edge_info.kind_)};
+    }
+    const std::string names_data = names.Build();
+
+    IndexHeader header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.router_type = static_cast<uint32_t>(rt.router_type_);
+    header.weight_size = sizeof(Weight);
+    header.weight_units_per_minute = static_cast<uint32_t>(WEIGHT_UNITS_PER_MINUTE);
+    header.input_hash = input_hash;
+    header.vertex_count = vertex_count;
+    header.edge_count = edge_count;
+    header.bus_count = bus_names.size();
+    header.names_size = names_data.size();
+    header.has_table = table_weights != nullptr;
+    header.shortcut_count = shortcuts.size();
+    header.forward_arc_count = forward_arcs.size();
+    header.backward_arc_count = backward_arcs.size();
+
+    //пишем во временный файл и переименовываем, чтобы другой процесс не прочитал его недописанным
+    const std::string tmp_path = rt.router_index_file_ + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        WriteArray(out, edges.data(), edges.size());
+        WriteArray(out, vertex_names.data(), vertex_names.size());
+        WriteArray(out, bus_names.data(), bus_names.size());
+        out.write(names_data.data(), names_data.size());
+        if (header.has_table) {
+            const size_t cell_count = vertex_count * vertex_count;
+            WriteArray(out, table_weights, cell_count);
+            WritePadding<Weight>(out, cell_count);
+            WriteArray(out, table_prev_edges, cell_count);
+            WritePadding<FlatRouter::PackedEdgeId>(out, cell_count);
+        }
+        WriteArray(out, shortcuts.data(), shortcuts.size());
+        WriteArray(out, forward_arcs.data(), forward_arcs.size());
+        WritePadding<uint32_t>(out, forward_arcs.size());
+        WriteArray(out, backward_arcs.data(), backward_arcs.size());
+        WritePadding<uint32_t>(out, backward_arcs.size());
+        if (!out) {
+            out.close();
+            std::remove(tmp_path.c_str());
+            throw std::runtime_error("Cannot write " + tmp_path);
+        }
+    }
+    if (std::rename(tmp_path.c_str(), rt.router_index_file_.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Cannot write " + rt.router_index_file_);
+    }
+}
+
+bool LoadRouterIndex(RoutingSettings& rt, const stat::RequestHandler& rh, uint64_t input_hash) {
+    std::shared_ptr<const MappedFile> file;
+    try {
+        file = std::make_shared<const MappedFile>(rt.router_index_file_);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+
+    if (file->GetSize() < sizeof(IndexHeader)) {
+        return false;
+    }
+    IndexHeader header;
+    std::memcpy(&header, file->GetData(), sizeof(header));
+    if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+        || header.version != INDEX_VERSION
+        || header.input_hash != input_hash
+        || header.router_type != static_cast<uint32_t>(rt.router_type_)
+        || header.weight_size != sizeof(Weight)
+        || header.weight_units_per_minute != static_cast<uint32_t>(WEIGHT_UNITS_PER_MINUTE)) {
+        return false;
+    }
+    if (!IsHeaderBounded(header, file->GetSize())) {
+        return false;
+    }
+    const IndexLayout layout(header);
+    if (file->GetSize() < layout.end) {
+        return false;
+    }
+
+    const VertexRecord* vertex_names = GetArray<VertexRecord>(*file, layout.vertex_names);
+    const NameRecord* bus_names = GetArray<NameRecord>(*file, layout.bus_names);
+    const EdgeRecord* edges = GetArray<EdgeRecord>(*file, layout.edges);
+
+    //названия ищутся в справочнике, поэтому индекс не зависит от адресов объектов
+    std::vector<const Bus*> buses(header.bus_count);
+    for (size_t bus_id = 0; bus_id < header.bus_count; ++bus_id) {
+        if (bus_names[bus_id].begin + bus_names[bus_id].length > header.names_size) {
+            return false;
+        }
+        buses[bus_id] = rh.FindBus(GetName(*file, layout, bus_names[bus_id]));
+        if (!buses[bus_id]) {
+            return false;
+        }
+    }
+
+    rt.ResetGraph(rh, header.vertex_count);
+    const auto is_valid_name = [&header](const NameRecord& record) {
+        return record.begin <= header.names_size && record.length <= header.names_size - record.begin;
+    };
+    for (size_t vertex_id = 0; vertex_id < header.vertex_count; ++vertex_id) {
+        const VertexRecord& vertex = vertex_names[vertex_id];
+        if (vertex.name.begin == NO_NAME) {
+            continue;
+        }
+        if (!is_valid_name(vertex.name)) {
+            return false;
+        }
+        const Stop* stop_ptr = rh.FindStop(GetName(*file, layout, vertex.name));
+        if (!stop_ptr) {
+            return false;
+        }
+        if (vertex.is_stop_vertex) {
+            stop_ptr->SetVertexId(vertex_id);
+        }
+        rt.vertex_id_to_stops_[vertex_id] = stop_ptr;
+        rt.used_vertex_count_ = vertex_id + 1;
+    }
+    for (size_t edge_id = 0; edge_id < header.edge_count; ++edge_id) {
+        const EdgeRecord& edge = edges[edge_id];
+        if (edge.from >= header.vertex_count || edge.to >= header.vertex_count || edge.bus >= header.bus_count
+            || edge.kind < static_cast<int32_t>(EdgeKind::SPAN) || edge.kind > static_cast<int32_t>(EdgeKind::ALIGHT)) {
+            return false;
+        }
+        const EdgeKind kind = static_cast<EdgeKind>(edge.kind);
+        rt.graph_.AddEdge(graph::Edge<Weight>(edge.from, edge.to, static_cast<Weight>(edge.weight)));
+        EdgeInfo edge_info{buses[edge.bus], edge.span_count, edge.road_distance, 0.0, kind};
+        edge_info.time_ = ComputeEdgeTime(edge_info, rt.bus_wait_time_, rt.bus_velocity_) - GetEdgeWaitTime(kind, rt.bus_wait_time_);
+        rt.edges_info_.push_back(edge_info);
+    }
+    rt.graph_.Freeze();
+
+    if (header.has_table) {
+        const Weight* weights = GetArray<Weight>(*file, layout.weights);
+        const FlatRouter::PackedEdgeId* prev_edges = GetArray<FlatRouter::PackedEdgeId>(*file, layout.prev_edges);
+        if (!IsTableConsistent(header, edges, weights, prev_edges)) {
+            return false;
+        }
+        rt.router_ = std::make_unique<RouteEngineImpl<FlatRouter>>(rt.graph_, weights, prev_edges);
+        rt.router_index_ = std::move(file);
+    } else if (rt.router_type_ == RouterType::CONTRACTION_HIERARCHY) {
+        std::vector<HierarchyRouter::Arc> shortcuts;
+        shortcuts.reserve(header.shortcut_count);
+        const ShortcutRecord* shortcut_records = GetArray<ShortcutRecord>(*file, layout.shortcuts);
+        for (size_t i = 0; i < header.shortcut_count; ++i) {
+            const ShortcutRecord& shortcut = shortcut_records[i];
+            shortcuts.push_back({shortcut.from, shortcut.to, static_cast<Weight>(shortcut.weight),
+                                 shortcut.first_child, shortcut.second_child});
+        }
+        const uint32_t* forward_arcs = GetArray<uint32_t>(*file, layout.forward_arcs);
+        const uint32_t* backward_arcs = GetArray<uint32_t>(*file, layout.backward_arcs);
+        try {
+            rt.router_ = std::make_unique<RouteEngineImpl<HierarchyRouter>>(
+                rt.graph_, std::move(shortcuts),
+                std::vector<graph::EdgeId>(forward_arcs, forward_arcs + header.forward_arc_count),
+                std::vector<graph::EdgeId>(backward_arcs, backward_arcs + header.backward_arc_count));
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+    } else {
+        rt.BuildRouter(rh);
+        return true;
+    }
+    rt.graph_search_ = std::make_unique<graph::DijkstraRouter<Weight>>(rt.graph_);
+    rt.components_ = graph::ComputeComponents(rt.graph_);
+    return true;
+}
+}// namespace routing
+}// namespace catalogue
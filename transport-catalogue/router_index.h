@@ -0,0 +1,40 @@
+#pragma once
+
+#include "request_handler.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <string>
+
+namespace catalogue {
+namespace routing {
+//файл, отображенный в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);                                   //выбрасывает исключение, если файл не открыт
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* GetData() const;
+    size_t GetSize() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    std::string buffer_;                                                            //без mmap файл читается целиком
+#endif
+};
+
+//сохраняет граф, соответствие вершин остановкам и ребер маршрутам, а также предварительный расчет
+//маршрутизатора: таблицу всех маршрутов (all_pairs и flat_all_pairs) или сокращения иерархии
+//(contraction_hierarchy); input_hash - хэш исходных данных и настроек маршрутизации
+void SaveRouterIndex(const RoutingSettings& rt, uint64_t input_hash);
+
+//загружает сохраненный маршрутизатор из rt.router_index_file_, если файл есть и построен
+//по тем же исходным данным; возвращает false, если граф и маршрутизатор нужно строить заново
+bool LoadRouterIndex(RoutingSettings& rt, const stat::RequestHandler& rh, uint64_t input_hash);
+}// namespace routing
+}// namespace catalogue
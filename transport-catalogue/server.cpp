@@ -0,0 +1,126 @@
+#include "server.h"
+
+#include "parallel.h"
+
+#include <exception>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace catalogue {
+namespace server {
+namespace {
+constexpr size_t STREAM_BATCH_PER_THREAD = 256;                 //строк на поток в пакете потокового режима
+
+json::Node MakeErrorAnswer(const json::Node& query, const std::string& message) {
+    using namespace std::literals;
+    json::Dict answer;
+    if (query.IsDict()) {
+        if (const auto it = query.AsDict().find("id"s); it != query.AsDict().end() && it->second.IsInt()) {
+            answer.emplace("request_id"s, it->second.AsInt());
+        }
+    }
+    answer.emplace("error_message"s, message);
+    return answer;
+}
+
+json::Node AnswerQuery(const Snapshot& snapshot, const json::Node& query) {
+    using namespace std::literals;
+    try {
+        if (std::optional<json::Dict> answer = reader::ExecuteStatRequest(snapshot.rh, snapshot.m, snapshot.rt, query.AsDict())) {
+            return std::move(*answer);
+        }
+        return MakeErrorAnswer(query, "unknown request type"s);
+    } catch (const std::exception& e) {
+        return MakeErrorAnswer(query, e.what());
+    }
+}
+}//namespace
+
+bool IsBlank(const std::string& message) {
+    return message.find_first_not_of(" \t\r") == std::string::npos;
+}
+
+std::string MakeErrorMessage(const std::string& message) {
+    std::ostringstream output;
+    json::PrintCompact(json::Document{MakeErrorAnswer(json::Node{}, message)}, output);
+    return output.str();
+}
+
+std::shared_ptr<const Snapshot> LoadSnapshot(const std::string& input_path) {
+    std::ifstream input(input_path);
+    if (!input) {
+        throw std::runtime_error("Cannot open " + input_path);
+    }
+    auto snapshot = std::make_shared<Snapshot>();
+    reader::FillCatalogue(snapshot->tc, snapshot->q, snapshot->r, snapshot->m, snapshot->rt, input);
+    snapshot->q.text_stat_.clear();
+    return snapshot;
+}
+
+std::string AnswerMessage(const Snapshot& snapshot, const std::string& message) {
+    std::optional<json::Document> request;
+    try {
+        std::istringstream input(message);
+        request = json::Load(input);
+    } catch (const std::exception& e) {
+        return MakeErrorMessage(e.what());
+    }
+
+    const json::Node& root = request->GetRoot();
+    std::ostringstream output;
+    if (root.IsArray()) {
+        json::Array answers;
+        answers.reserve(root.AsArray().size());
+        for (const json::Node& query : root.AsArray()) {
+            answers.push_back(AnswerQuery(snapshot, query));
+        }
+        json::PrintCompact(json::Document{std::move(answers)}, output);
+    } else {
+        json::PrintCompact(json::Document{AnswerQuery(snapshot, root)}, output);
+    }
+    return output.str();
+}
+
+void ServeStream(std::istream& input, std::ostream& output, const Snapshot& snapshot) {
+    const size_t worker_count = parallel::ResolveThreadCount(snapshot.q.stat_threads_);
+    const size_t max_batch_size = worker_count * STREAM_BATCH_PER_THREAD;
+    std::vector<std::string> messages;
+    std::vector<std::string> answers;
+    std::string block;
+    bool is_open = true;
+    while (is_open) {
+        //в пакет берутся только строки, которые уже можно прочитать без ожидания,
+        //поэтому готовые ответы не ждут следующих запросов
+        messages.clear();
+        do {
+            std::string message;
+            if (!std::getline(input, message)) {
+                is_open = false;
+                break;
+            }
+            if (!IsBlank(message)) {
+                messages.push_back(std::move(message));
+            }
+        } while (messages.size() < max_batch_size && input.rdbuf()->in_avail() > 0);
+
+        answers.resize(messages.size());
+        parallel::ForEachIndex(messages.size(), worker_count, [&](size_t index) {
+            answers[index] = AnswerMessage(snapshot, messages[index]);
+        });
+
+        //ответы пакета выводятся одной записью и сразу выталкиваются
+        block.clear();
+        for (const std::string& answer : answers) {
+            block += answer;
+            block.push_back('\n');
+        }
+        output.write(block.data(), static_cast<std::streamsize>(block.size()));
+        output.flush();
+    }
+}
+}//namespace server
+}//namespace catalogue
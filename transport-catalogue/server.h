@@ -0,0 +1,74 @@
+#pragma once
+
+#include "json.h"
+#include "json_reader.h"
+#include "map_renderer.h"
+#include "request_handler.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace catalogue {
+namespace server {
+//снимок справочника со всем, что нужно для ответов: после загрузки не меняется.
+//Названия в справочнике ссылаются на текст запросов, карта и маршрутизатор - на справочник и настройки,
+//поэтому снимок не копируется и не перемещается, а запросы объявлены первыми и удаляются последними
+struct Snapshot {
+    Snapshot() : rh(tc) {
+    }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    reader::Query q;                                            //запросы на заполнение справочника
+    head::TransportCatalogue tc;                                //справочник
+    renderer::RenderSettings r;                                 //настройки визуализации
+    renderer::MapObjects m;                                     //объекты визуализации
+    routing::RoutingSettings rt;                                //настройки маршрутизации
+    stat::RequestHandler rh;                                    //запросы к справочнику
+};
+
+//строит снимок из файла с base_requests и настройками, stat_requests не выполняются
+std::shared_ptr<const Snapshot> LoadSnapshot(const std::string& input_path);
+
+//текущий опубликованный снимок. Читатель берет снимок на время запроса и не мешает публикации нового:
+//запросы, начатые до публикации, заканчиваются на старом снимке, а он удаляется, когда его отпустит последний читатель
+class SnapshotHolder {
+public:
+    explicit SnapshotHolder(std::shared_ptr<const Snapshot> snapshot) : snapshot_(std::move(snapshot)) {
+    }
+
+    std::shared_ptr<const Snapshot> Get() const {
+        return std::atomic_load(&snapshot_);
+    }
+
+    void Publish(std::shared_ptr<const Snapshot> snapshot) {
+        std::atomic_store(&snapshot_, std::move(snapshot));
+    }
+
+private:
+    std::shared_ptr<const Snapshot> snapshot_;
+};
+
+//сообщение из одних пробелов пропускается без ответа
+bool IsBlank(const std::string& message);
+
+//ответ {"error_message": message} в одну строку для сообщения, в котором нет разобранного запроса
+std::string MakeErrorMessage(const std::string& message);
+
+//ответ на одно сообщение: объект запроса или массив запросов в одной строке. Ответ - json в одну строку
+//без перевода строки. Ошибки разбора и выполнения возвращаются как {"error_message": ...},
+//поэтому на каждый запрос есть ответ
+std::string AnswerMessage(const Snapshot& snapshot, const std::string& message);
+
+//потоковый режим: каждая строка input - сообщение, как для AnswerMessage, ответ выводится одной строкой в output.
+//Строки, уже доступные для чтения, отвечаются пакетом в snapshot.q.stat_threads_ потоках в исходном порядке,
+//ответы пакета выводятся одной записью. Работает до конца input
+void ServeStream(std::istream& input, std::ostream& output, const Snapshot& snapshot);
+}//namespace server
+}//namespace catalogue
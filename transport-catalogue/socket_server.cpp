@@ -0,0 +1,390 @@
+#include "socket_server.h"
+
+//Unix-сокеты и сигналы есть только в POSIX
+#ifndef _WIN32
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace catalogue {
+namespace server {
+namespace {
+constexpr size_t MAX_MESSAGE_SIZE = 16 * 1024 * 1024;           //длина сообщения, после которой соединение закрывается
+constexpr size_t MAX_PENDING_SIZE = MAX_MESSAGE_SIZE;           //неотвеченных байт соединения, после которых чтение приостанавливается
+constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+constexpr int WRITE_TIMEOUT_MS = 10000;
+constexpr int PAUSED_POLL_MS = 50;                              //как часто проверяются соединения с приостановленным чтением
+
+//дескриптор, закрываемый в деструкторе
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd) : fd_(fd) {
+    }
+
+    ~FileDescriptor() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int Get() const {
+        return fd_;
+    }
+
+private:
+    int fd_;
+};
+
+//сокеты соединений неблокирующие: при заполненном буфере отправки ответ ждет не дольше WRITE_TIMEOUT_MS
+bool WriteAll(int fd, const std::string& data) {
+    for (size_t written = 0; written < data.size();) {
+        //MSG_NOSIGNAL: закрытое клиентом соединение не завершает процесс сигналом SIGPIPE
+        const ssize_t count = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd output{fd, POLLOUT, 0};
+            const int ready = poll(&output, 1, WRITE_TIMEOUT_MS);
+            if (ready == 0 || (ready < 0 && errno != EINTR)) {
+                return false;
+            }
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+//соединение клиента. Прочитанные полные сообщения ждут в очереди и отвечаются по одному в порядке получения
+struct Connection {
+    explicit Connection(int fd) : socket(fd) {
+    }
+
+    FileDescriptor socket;                                      //закрывается, когда соединение отпустят поток чтения и рабочие потоки
+    std::string buffer;                                         //начало еще не полного сообщения, только для потока чтения
+
+    //поля ниже защищены мьютексом MessageQueue
+    std::deque<std::string> messages;                           //полные сообщения без ответа
+    size_t pending_size = 0;                                    //байт в messages и в сообщении, которое сейчас отвечается
+    bool is_active = false;                                     //соединение в очереди готовых или его сообщение отвечается
+    bool is_broken = false;                                     //ответ не отправился, остальные сообщения не отвечаются
+    bool is_too_long = false;                                   //после сообщений из очереди ответить ошибкой длины
+};
+
+//общая очередь рабочих потоков. В ней соединения, а не сообщения: сообщения одного соединения отвечаются
+//по очереди и в исходном порядке, а соединения без сообщений не занимают рабочие потоки
+class MessageQueue {
+public:
+    void Push(const std::shared_ptr<Connection>& connection, std::string message) {
+        std::lock_guard guard(mutex_);
+        if (connection->is_broken) {
+            return;
+        }
+        connection->pending_size += message.size();
+        connection->messages.push_back(std::move(message));
+        Activate(connection);
+    }
+
+    void PushTooLong(const std::shared_ptr<Connection>& connection) {
+        std::lock_guard guard(mutex_);
+        connection->is_too_long = true;
+        Activate(connection);
+    }
+
+    //ждет сообщение; пустой указатель - очередь остановлена. Пустое message при непустом соединении - ошибка длины
+    std::shared_ptr<Connection> Pop(std::string& message) {
+        std::unique_lock lock(mutex_);
+        is_ready_.wait(lock, [this]() {
+            return is_stopped_ || !ready_.empty();
+        });
+        if (is_stopped_) {
+            return nullptr;
+        }
+        std::shared_ptr<Connection> connection = std::move(ready_.front());
+        ready_.pop_front();
+        message.clear();
+        if (!connection->messages.empty()) {
+            message = std::move(connection->messages.front());
+            connection->messages.pop_front();
+        }
+        return connection;
+    }
+
+    //сообщение соединения отвечено; остальные его сообщения встают в конец очереди, чтобы не задерживать другие соединения
+    void Done(const std::shared_ptr<Connection>& connection, size_t message_size, bool is_sent) {
+        std::lock_guard guard(mutex_);
+        connection->pending_size -= message_size;
+        if (!is_sent) {
+            connection->is_broken = true;
+            connection->messages.clear();
+            connection->pending_size = 0;
+            connection->is_too_long = false;
+        }
+        connection->is_active = false;
+        if (message_size == 0) {
+            connection->is_too_long = false;
+        }
+        if (!connection->messages.empty() || connection->is_too_long) {
+            Activate(connection);
+        }
+    }
+
+    bool IsPaused(const Connection& connection) const {
+        std::lock_guard guard(mutex_);
+        return connection.pending_size > MAX_PENDING_SIZE;
+    }
+
+    void Stop() {
+        {
+            std::lock_guard guard(mutex_);
+            is_stopped_ = true;
+        }
+        is_ready_.notify_all();
+    }
+
+private:
+    void Activate(const std::shared_ptr<Connection>& connection) {
+        if (!connection->is_active) {
+            connection->is_active = true;
+            ready_.push_back(connection);
+            is_ready_.notify_one();
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable is_ready_;
+    std::deque<std::shared_ptr<Connection>> ready_;
+    bool is_stopped_ = false;
+};
+
+//рабочий поток: снимок берется заново для каждого сообщения, чтобы долгие соединения получали перезагруженный справочник.
+//Если рабочих потоков несколько, вложенные расчеты выполняются в самом рабочем потоке (см. parallel::WorkerScope)
+void AnswerMessages(MessageQueue& queue, const SnapshotHolder& holder, bool is_one_of_many) {
+    using namespace std::literals;
+    std::optional<parallel::WorkerScope> scope;
+    if (is_one_of_many) {
+        scope.emplace();
+    }
+    std::string message;
+    while (const std::shared_ptr<Connection> connection = queue.Pop(message)) {
+        std::string answer;
+        if (message.empty()) {
+            answer = MakeErrorMessage("message is too long"s);
+        } else {
+            answer = AnswerMessage(*holder.Get(), message);
+        }
+        answer.push_back('\n');
+        const bool is_sent = WriteAll(connection->socket.Get(), answer);
+        if (!is_sent || message.empty()) {
+            //поток чтения увидит закрытие в poll и отпустит соединение
+            shutdown(connection->socket.Get(), SHUT_RDWR);
+        }
+        queue.Done(connection, message.size(), is_sent);
+    }
+}
+
+//читает одну порцию данных соединения и ставит полные сообщения в очередь; false - соединение больше не читается.
+//Остаток данных poll вернет на следующем круге, поэтому быстрый клиент не задерживает чтение остальных
+bool ReadMessages(const std::shared_ptr<Connection>& connection, MessageQueue& queue) {
+    std::string& buffer = connection->buffer;
+    const size_t scanned = buffer.size();
+    buffer.resize(scanned + READ_CHUNK_SIZE);
+    ssize_t received = 0;
+    do {
+        received = recv(connection->socket.Get(), buffer.data() + scanned, READ_CHUNK_SIZE, 0);
+    } while (received < 0 && errno == EINTR);
+    buffer.resize(scanned + static_cast<size_t>(std::max<ssize_t>(received, 0)));
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;
+    }
+    if (received <= 0) {
+        return false;
+    }
+
+    size_t begin = 0;
+    for (size_t end = buffer.find('\n', scanned); end != std::string::npos; end = buffer.find('\n', begin)) {
+        std::string message = buffer.substr(begin, end - begin);
+        begin = end + 1;
+        if (!IsBlank(message)) {
+            queue.Push(connection, std::move(message));
+        }
+    }
+    buffer.erase(0, begin);
+    //строка без перевода строки не растет без ограничения: на нее отвечают ошибкой и закрывают соединение
+    if (buffer.size() > MAX_MESSAGE_SIZE) {
+        buffer.clear();
+        queue.PushTooLong(connection);
+        return false;
+    }
+    return true;
+}
+
+//вызывающий поток принимает соединения и читает сообщения всех соединений через poll,
+//worker_count рабочих потоков отвечают на сообщения из общей очереди
+void ServeConnections(const std::string& socket_path, int listener, const SnapshotHolder& holder, size_t worker_count) {
+    MessageQueue queue;
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(AnswerMessages, std::ref(queue), std::cref(holder), worker_count > 1);
+    }
+
+    try {
+        std::vector<std::shared_ptr<Connection>> connections;
+        std::vector<pollfd> descriptors;
+        while (true) {
+            //соединения с большой очередью неотвеченных сообщений не читаются, пока рабочие потоки ее не разберут
+            bool is_any_paused = false;
+            descriptors.assign(1, pollfd{listener, POLLIN, 0});
+            for (const std::shared_ptr<Connection>& connection : connections) {
+                const bool is_paused = queue.IsPaused(*connection);
+                is_any_paused = is_any_paused || is_paused;
+                descriptors.push_back(pollfd{connection->socket.Get(), static_cast<short>(is_paused ? 0 : POLLIN), 0});
+            }
+            if (poll(descriptors.data(), descriptors.size(), is_any_paused ? PAUSED_POLL_MS : -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Cannot poll " + socket_path + ": " + std::strerror(errno));
+            }
+
+            //закрытые соединения отпускаются: их сообщения в очереди все равно будут отвечены
+            std::vector<std::shared_ptr<Connection>> open_connections;
+            open_connections.reserve(connections.size());
+            for (size_t i = 0; i < connections.size(); ++i) {
+                if (descriptors[i + 1].revents == 0 || ReadMessages(connections[i], queue)) {
+                    open_connections.push_back(std::move(connections[i]));
+                }
+            }
+            connections = std::move(open_connections);
+
+            if (descriptors[0].revents != 0) {
+                while (true) {
+                    const int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                    if (fd >= 0) {
+                        connections.push_back(std::make_shared<Connection>(fd));
+                        continue;
+                    }
+                    if (errno == EINTR || errno == ECONNABORTED) {
+                        continue;
+                    }
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        break;
+                    }
+                    throw std::runtime_error("Cannot accept " + socket_path + ": " + std::strerror(errno));
+                }
+            }
+        }
+    } catch (...) {
+        queue.Stop();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        throw;
+    }
+}
+}//namespace
+
+void ServeUnixSocket(const std::string& socket_path, const std::string& input_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::length_error("Invalid socket path " + socket_path);
+    }
+    std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+
+    //сокет, оставшийся от прошлого запуска, удаляется; другие файлы не трогаем
+    struct stat info{};
+    if (lstat(socket_path.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            throw std::runtime_error("Not a socket " + socket_path);
+        }
+        unlink(socket_path.c_str());
+    }
+
+    //слушающий сокет неблокирующий: соединения принимаются, пока есть ожидающие, затем поток возвращается в poll
+    const FileDescriptor listener(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0));
+    if (listener.Get() < 0) {
+        throw std::runtime_error("Cannot create socket " + socket_path);
+    }
+    if (bind(listener.Get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        throw std::runtime_error("Cannot bind " + socket_path + ": " + std::strerror(errno));
+    }
+    if (listen(listener.Get(), SOMAXCONN) < 0) {
+        throw std::runtime_error("Cannot listen " + socket_path + ": " + std::strerror(errno));
+    }
+
+    //SIGHUP блокируется до запуска потоков, поэтому его получает только поток перезагрузки через sigwait
+    sigset_t reload_signals;
+    sigemptyset(&reload_signals);
+    sigaddset(&reload_signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &reload_signals, nullptr);
+
+    SnapshotHolder holder(LoadSnapshot(input_path));
+    std::atomic<bool> is_stopped{false};
+    std::thread reloader([&]() {
+        while (true) {
+            int signal = 0;
+            sigwait(&reload_signals, &signal);
+            if (is_stopped) {
+                return;
+            }
+            try {
+                //новый снимок строится, пока запросы отвечаются по старому
+                const std::shared_ptr<const Snapshot> previous = holder.Get();
+                holder.Publish(LoadSnapshot(input_path));
+                std::cerr << "Reloaded " << input_path << std::endl;
+                //кэши нового снимка пусты, поэтому выводятся итоговые счетчики прежнего
+                reader::PrintRouterStats(previous->rt, std::cerr);
+            } catch (const std::exception& e) {
+                std::cerr << "Cannot reload " << input_path << ", keeping the previous catalogue: " << e.what() << std::endl;
+            }
+        }
+    });
+
+    const size_t worker_count = parallel::ResolveThreadCount(holder.Get()->q.stat_threads_);
+    std::cerr << "Serving " << socket_path << " with " << worker_count << " threads" << std::endl;
+    try {
+        ServeConnections(socket_path, listener.Get(), holder, worker_count);
+    } catch (...) {
+        reader::PrintRouterStats(holder.Get()->rt, std::cerr);
+        //поток перезагрузки будится своим сигналом и завершается
+        is_stopped = true;
+        pthread_kill(reloader.native_handle(), SIGHUP);
+        reloader.join();
+        throw;
+    }
+}
+}//namespace server
+}//namespace catalogue
+#endif
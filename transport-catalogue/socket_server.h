@@ -0,0 +1,21 @@
+#pragma once
+
+#include "server.h"
+
+#include <string>
+
+namespace catalogue {
+namespace server {
+#ifndef _WIN32
+//загружает снимок из input_path и обслуживает запросы по Unix-сокету socket_path, пока слушающий сокет не сломается.
+//Вызывающий поток принимает соединения и читает сообщения через poll, отвечают stat_threads рабочих потоков
+//из первого снимка. Сообщения одного соединения отвечаются по порядку, соединения без сообщений потоки не занимают.
+//Сообщения и ответы разделяются переводом строки, пустые строки пропускаются. На сообщение длиннее 16 МБ
+//отвечается ошибка, и соединение закрывается; соединение, которое не читает ответы, закрывается через 10 с.
+//По сигналу SIGHUP input_path перечитывается в отдельном потоке, и новый снимок публикуется без остановки ответов;
+//если загрузка не удалась, остается прежний снимок. Счетчики кэшей выводятся в std::cerr при замене снимка
+//и при остановке, в любой момент их возвращает запрос RouterStats
+void ServeUnixSocket(const std::string& socket_path, const std::string& input_path);
+#endif
+}//namespace server
+}//namespace catalogue
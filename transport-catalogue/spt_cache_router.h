@@ -0,0 +1,141 @@
+#pragma once
+
+#include "graph.h"
+#include "lru_cache.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск по запросу с запоминанием деревьев кратчайших путей: для начала маршрута
+// один раз рассчитываются веса и последние ребра маршрутов во все вершины,
+// следующие маршруты из той же вершины восстанавливаются по дереву без поиска.
+// Хранятся деревья недавно использованных начальных вершин, не больше max_tree_count
+// и не больше max_bytes байт (0 - без ограничения); дерево занимает V * (sizeof(Weight) + 4) байт.
+// Потокобезопасен: деревья неизменяемы и после вытеснения живут, пока их используют.
+template <typename Weight>
+class SptCacheRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+    using PackedEdgeId = uint32_t;
+
+    explicit SptCacheRouter(const Graph& graph, size_t max_tree_count, size_t max_bytes = 0);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    cache::CacheStats GetStats() const {
+        return trees_.GetStats();
+    }
+
+    // память под одно дерево графа с vertex_count вершинами
+    static size_t GetTreeBytes(size_t vertex_count) {
+        return vertex_count * (sizeof(Weight) + sizeof(PackedEdgeId));
+    }
+
+private:
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr PackedEdgeId NO_EDGE = std::numeric_limits<PackedEdgeId>::max();
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                              ? std::numeric_limits<Weight>::infinity()
+                                              : std::numeric_limits<Weight>::max();
+
+    struct ShortestPathTree {
+        std::vector<Weight> weights;                            // вес маршрута до вершины
+        std::vector<PackedEdgeId> prev_edges;                   // последнее ребро маршрута до вершины
+    };
+
+    std::shared_ptr<const ShortestPathTree> ComputeTree(VertexId from) const;
+
+    const Graph& graph_;
+    const FrozenIncidence<Weight>& incidence_;
+    mutable cache::LruCache<VertexId, std::shared_ptr<const ShortestPathTree>> trees_;
+};
+
+template <typename Weight>
+SptCacheRouter<Weight>::SptCacheRouter(const Graph& graph, size_t max_tree_count, size_t max_bytes)
+    : graph_(graph)
+    , incidence_(graph.GetFrozenIncidence())
+    , trees_(std::max<size_t>(max_tree_count, 1), max_bytes)
+{
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for shortest path trees");
+    }
+    for (const Weight weight : incidence_.weights) {
+        if (weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::shared_ptr<const typename SptCacheRouter<Weight>::ShortestPathTree> SptCacheRouter<Weight>::ComputeTree(VertexId from) const {
+    using HeapItem = std::pair<Weight, VertexId>;
+    auto tree = std::make_shared<ShortestPathTree>();
+    tree->weights.assign(graph_.GetVertexCount(), INFINITE_WEIGHT);
+    tree->prev_edges.assign(graph_.GetVertexCount(), NO_EDGE);
+    std::vector<HeapItem> heap;
+    tree->weights[from] = ZERO_WEIGHT;
+    heap.emplace_back(ZERO_WEIGHT, from);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+        const auto [weight, vertex] = heap.back();
+        heap.pop_back();
+        if (tree->weights[vertex] < weight) {
+            continue;
+        }
+        for (size_t arc = incidence_.offsets[vertex]; arc < incidence_.offsets[vertex + 1]; ++arc) {
+            const VertexId next = incidence_.targets[arc];
+            const Weight candidate_weight = weight + incidence_.weights[arc];
+            if (candidate_weight < tree->weights[next]) {
+                tree->weights[next] = candidate_weight;
+                tree->prev_edges[next] = static_cast<PackedEdgeId>(incidence_.edge_ids[arc]);
+                heap.emplace_back(candidate_weight, next);
+                std::push_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+            }
+        }
+    }
+    return tree;
+}
+
+template <typename Weight>
+std::optional<typename SptCacheRouter<Weight>::RouteInfo> SptCacheRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    // дерево считается без блокировки кэша: два потока могут посчитать одно дерево дважды
+    std::shared_ptr<const ShortestPathTree> tree;
+    if (auto cached = trees_.Find(from)) {
+        tree = std::move(*cached);
+    } else {
+        tree = ComputeTree(from);
+        trees_.Insert(from, tree, GetTreeBytes(vertex_count));
+    }
+
+    const Weight weight = tree->weights[to];
+    if (weight == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (PackedEdgeId edge_id = tree->prev_edges[to]; edge_id != NO_EDGE; edge_id = tree->prev_edges[graph_.GetEdge(edge_id).from]) {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
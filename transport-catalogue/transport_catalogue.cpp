@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>
 
 namespace catalogue {
 namespace head {
@@ -56,6 +57,41 @@ void TransportCatalogue::AddRoute(std::pair<const Bus*, std::vector<const Stop*>
     }
 }
 
+const domain::Stop* TransportCatalogue::InsertStop(std::string_view name, double latitude, double longitude) {
+    using namespace std::literals;
+    if (stopname_to_stop_.count(name)) {
+        throw std::invalid_argument("Stop already exists"s);
+    }
+    const std::string_view stored_name = names_.emplace_back(name);
+    const Stop* stop_ptr = &stops_.emplace_back(stored_name, latitude, longitude);
+    stopname_to_stop_.insert({stored_name, stop_ptr});
+    return stop_ptr;
+}
+
+const domain::Bus* TransportCatalogue::InsertBus(std::string_view name, bool is_ring, std::vector<const Stop*> stops) {
+    using namespace std::literals;
+    if (busname_to_bus_.count(name)) {
+        throw std::invalid_argument("Bus already exists"s);
+    }
+    if (stops.empty()) {
+        throw std::invalid_argument("Bus should have stops"s);
+    }
+    const std::string_view stored_name = names_.emplace_back(name);
+    const Bus* bus_ptr = &buses_.emplace_back(stored_name, is_ring);
+    busname_to_bus_.insert({stored_name, bus_ptr});
+    std::pair<const Bus*, std::vector<const Stop*>> bus_route{bus_ptr, std::move(stops)};
+    AddRoute(bus_route);
+    return bus_ptr;
+}
+
+void TransportCatalogue::RemoveBus(const Bus* bus_ptr) {
+    //сам маршрут остается в деке, чтобы указатели на него в других структурах не стали висячими
+    busname_to_bus_.erase(bus_ptr->GetBus());
+    for (const Stop* stop_ptr : bus_ptr->GetBusAndStops()) {
+        stop_ptr->RemoveBusFromRoute(bus_ptr);
+    }
+}
+
 double TransportCatalogue::ComputeGeoDistance(const Bus* bus_ptr, const int route_size) const {
     double l_route_geo = 0.0;
     for (auto i = 0; i < route_size - 1; ++i) {
@@ -28,6 +28,11 @@ public:
     void AddBusDirectory();                                                                         //добавление словаря маршрутов
     void AddRoute(std::pair<const Bus*, std::vector<const Stop*>>& bus_route);                      //добавление остановок маршрута
 
+    //изменения уже заполненного справочника; названия копируются в справочник
+    const Stop* InsertStop(std::string_view name, double latitude, double longitude);               //добавление остановки с записью в словарь
+    const Bus* InsertBus(std::string_view name, bool is_ring, std::vector<const Stop*> stops);      //добавление маршрута с остановками и записью в словарь
+    void RemoveBus(const Bus* bus_ptr);                                                             //удаление маршрута из словаря и из списков маршрутов остановок
+
     double ComputeGeoDistance(const Bus* bus_ptr, const int route_size) const;                      //расчет географического расстояния
     int ComputeMapDistance(const Bus* bus_ptr, const int route_size) const;                         //расчет расстояния по справочнику расстояний
     double ComputeCurvature(const double l_route_geo, const int l_route_map) const;                 //расчет соотношения
@@ -46,6 +51,7 @@ public:
     std::unordered_map<std::string_view, const Bus*> busname_to_bus_;                                   //словарь название маршрута - указатель
 
     std::unordered_map<std::pair<const Stop*, const Stop*>, int, PairStopPtrHasher> stops_distance_;    //словарь с расстоянием между остановками
+    std::deque<std::string> names_;                                                                     //названия остановок и маршрутов, добавленных после заполнения
 };
 }//namespace head
 }//namespace catalogue
\ No newline at end of file
@@ -1,114 +1,592 @@
 #include "transport_router.h"
+#include "geo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 namespace catalogue {
 namespace routing {
-graph::Edge<double> RoutingSettings::BuildEdge(const Stop* from, const Stop* to, size_t& vertex_id, double road_distance) {
-    double time_for_edge = ComputeTimeForEdge(bus_wait_time_, bus_velocity_, road_distance);
+namespace {
+constexpr int HILBERT_ORDER = 16;                                                   //сторона решетки кривой Гильберта 2^16
+
+//номер клетки (x, y) на кривой Гильберта порядка HILBERT_ORDER
+uint64_t ComputeHilbertIndex(uint32_t x, uint32_t y) {
+    uint64_t index = 0;
+    for (uint32_t side = 1u << (HILBERT_ORDER - 1); side > 0; side /= 2) {
+        const uint32_t rx = (x & side) > 0;
+        const uint32_t ry = (y & side) > 0;
+        index += static_cast<uint64_t>(side) * side * ((3 * rx) ^ ry);
+        //поворот четверти, чтобы кривая внутри нее начиналась у предыдущей
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - (x & (side - 1));
+                y = side - 1 - (y & (side - 1));
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+}// namespace
 
-    if (auto it = stops_to_vertex_id_.find(from); it == stops_to_vertex_id_.end()) {
-        stops_to_vertex_id_.insert({from, vertex_id});
-        vertex_id_to_stops_.insert({vertex_id, from});
-        ++vertex_id;
+graph::VertexId RoutingSettings::AllocateVertex(const Stop* stop_ptr) {
+    if (used_vertex_count_ == graph_.GetVertexCount()) {
+        graph_.AddVertex();
+        vertex_id_to_stops_.push_back(nullptr);
     }
-    if (auto it = stops_to_vertex_id_.find(to); it == stops_to_vertex_id_.end()) {
-        stops_to_vertex_id_.insert({to, vertex_id});
-        vertex_id_to_stops_.insert({vertex_id, to});
-        ++vertex_id;
+    vertex_id_to_stops_[used_vertex_count_] = stop_ptr;
+    return used_vertex_count_++;
+}
+
+graph::Edge<Weight> RoutingSettings::BuildEdge(const Stop* from, const Stop* to, double road_distance) {
+    double time_for_edge = ComputeTimeForEdge(bus_wait_time_, bus_velocity_, road_distance);
+
+    for (const Stop* stop_ptr : {from, to}) {
+        if (stop_ptr->GetVertexId() == Stop::NO_VERTEX) {
+            stop_ptr->SetVertexId(AllocateVertex(stop_ptr));
+        }
     }
 
-    size_t index_from = stops_to_vertex_id_[from];
-    size_t index_to = stops_to_vertex_id_[to];
-    graph::Edge<double> edge(index_from, index_to, time_for_edge);
+    graph::Edge<Weight> edge(from->GetVertexId(), to->GetVertexId(), ToWeight(time_for_edge));
     return edge;
 }
 
-void RoutingSettings::AddEdge(const graph::Edge<double>& edge, const Bus* bus_ptr, size_t& edge_id, int span_count) {
+void RoutingSettings::AddEdge(const graph::Edge<Weight>& edge, const Bus* bus_ptr, size_t& edge_id, int span_count, int road_distance,
+                              EdgeKind kind) {
     graph_.AddEdge(edge);
-    buses_to_edge_id_.insert({edge_id, std::make_pair(bus_ptr, span_count)});
+    //время в пути хранится в минутах без округления до единиц веса, как и выводится в ответах
+    EdgeInfo edge_info{bus_ptr, span_count, road_distance, 0.0, kind};
+    edge_info.time_ = ComputeEdgeTime(edge_info, bus_wait_time_, bus_velocity_) - GetEdgeWaitTime(kind, bus_wait_time_);
+    edges_info_.push_back(edge_info);
     ++edge_id;
 }
 
+void RoutingSettings::ResetGraph(const stat::RequestHandler &rh, size_t vertex_count) {
+    for (const Stop* stop_ptr : rh.GetStopsPtr()) {
+        stop_ptr->SetVertexId(Stop::NO_VERTEX);
+    }
+    graph_ = graph::DirectedWeightedGraph<Weight>(vertex_count);
+    vertex_id_to_stops_.assign(vertex_count, nullptr);
+    edges_info_.clear();
+    used_vertex_count_ = 0;
+}
+
 void RoutingSettings::BuildGraph(const stat::RequestHandler &rh) {
-    std::unordered_set<const Bus*> all_buses = rh.GetBusesPtr();
-    std::unordered_set<const Stop*> all_stops_set = rh.GetStopsPtr();
-    graph::DirectedWeightedGraph<double> graph(all_stops_set.size());
-    
-    graph_ = graph;
-    
-    size_t vertex_id = 0;
-    size_t edge_id = 0;
+    //маршруты обходятся по названиям, чтобы номера вершин не зависели от адресов в памяти
+    const std::unordered_set<const Bus*> bus_set = rh.GetBusesPtr();
+    std::vector<const Bus*> all_buses(bus_set.begin(), bus_set.end());
+    std::sort(all_buses.begin(), all_buses.end(), [](const Bus* lhs, const Bus* rhs) {
+        return lhs->GetBus() < rhs->GetBus();
+    });
+    ResetGraph(rh, rh.GetStopsPtr().size());
 
+    size_t edge_id = 0;
     for (const auto bus_ptr : all_buses) {
-        std::vector<const Stop*> all_stops = bus_ptr->GetBusAndStops();
-        if (!all_stops.empty()) {
-            auto start = all_stops.begin();
-            auto finish = all_stops.end();
-            if (!bus_ptr->IsRing()) {
-                finish = std::next(start, all_stops.size() / 2 + 1);
-            }
+        AddBusEdges(rh, bus_ptr, edge_id);
+    }
+    if (vertex_order_ != VertexOrder::INPUT) {
+        ReorderVertices();
+    }
+    graph_.Freeze();
+}
+
+void RoutingSettings::AddBusEdges(const stat::RequestHandler &rh, const Bus* bus_ptr, size_t& edge_id) {
+    switch (graph_model_) {
+    case GraphModel::SPANS:
+        AddBusSpans(rh, bus_ptr, edge_id);
+        break;
+    case GraphModel::RIDE_CHAINS:
+        AddBusRideChains(rh, bus_ptr, edge_id);
+        break;
+    }
+}
+
+void RoutingSettings::AddBusSpans(const stat::RequestHandler &rh, const Bus* bus_ptr, size_t& edge_id) {
+    std::vector<const Stop*> all_stops = bus_ptr->GetBusAndStops();
+    if (!all_stops.empty()) {
+        auto start = all_stops.begin();
+        auto finish = all_stops.end();
+        if (!bus_ptr->IsRing()) {
+            finish = std::next(start, all_stops.size() / 2 + 1);
+        }
 
-            for (auto it = start; it != std::prev(finish); ++it) {
-                auto first = it;
-                auto prev_last = it;
-                auto last = std::next(it);
+        for (auto it = start; it != std::prev(finish); ++it) {
+            auto first = it;
+            auto prev_last = it;
+            auto last = std::next(it);
 
-                double road_distance = 0.0;
-                double road_distance_reverse = 0.0;
+            double road_distance = 0.0;
+            double road_distance_reverse = 0.0;
 
-                while (last != finish) {
-                    const Stop* from = *first;
-                    const Stop *prev = *prev_last;
-                    const Stop* to = *last;
+            while (last != finish) {
+                const Stop* from = *first;
+                const Stop *prev = *prev_last;
+                const Stop* to = *last;
 
-                    road_distance += rh.ComputeDistance(prev, to);
-                    int span_count = static_cast<int>(std::distance(first, last));
+                road_distance += rh.ComputeDistance(prev, to);
+                int span_count = static_cast<int>(std::distance(first, last));
+
+                const graph::Edge<Weight> edge = BuildEdge(from, to, road_distance);
+                AddEdge(edge, bus_ptr, edge_id, span_count, static_cast<int>(road_distance));
+
+                if (!bus_ptr->IsRing()) {
+                    road_distance_reverse += rh.ComputeDistance(to, prev);
+                    const graph::Edge<Weight> edge = BuildEdge(to, from, road_distance_reverse);
+                    AddEdge(edge, bus_ptr, edge_id, span_count, static_cast<int>(road_distance_reverse));
+                }
+                ++prev_last;
+                ++last;
+            }
+        }
+    }
+}
 
-                    const graph::Edge<double> edge = BuildEdge(from, to, vertex_id, road_distance);
-                    AddEdge(edge, bus_ptr, edge_id, span_count);
+void RoutingSettings::AddBusRideChains(const stat::RequestHandler &rh, const Bus* bus_ptr, size_t& edge_id) {
+    const std::vector<const Stop*> all_stops = bus_ptr->GetBusAndStops();
+    if (all_stops.empty()) {
+        return;
+    }
+    //кольцевой маршрут - одна цепочка, некольцевой - две: до конечной и обратно, как отрезки в RAPTOR.
+    //На каждой позиции маршрута своя вершина в автобусе, поэтому ребер столько же, сколько позиций,
+    //а пересадка на конечной некольцевого маршрута, как и в графе из пар остановок, требует ожидания
+    //Ребра высадки весят 0, а при bus_wait_time 0 и посадки: остановка и вершина в автобусе образуют
+    //цикл нулевого веса. Веса не завышаются, чтобы не менять время маршрута, - такие циклы
+    //допускают все маршрутизаторы (FlatRouter различает равные по весу маршруты числом ребер)
+    std::vector<std::pair<size_t, size_t>> chains;
+    if (bus_ptr->IsRing()) {
+        chains.emplace_back(0, all_stops.size());
+    } else {
+        const size_t middle = all_stops.size() / 2;
+        chains.emplace_back(0, middle + 1);
+        chains.emplace_back(middle, all_stops.size());
+    }
 
-                    if (!bus_ptr->IsRing()) {
-                        road_distance_reverse += rh.ComputeDistance(to, prev);
-                        const graph::Edge<double> edge = BuildEdge(to, from, vertex_id, road_distance_reverse);
-                        AddEdge(edge, bus_ptr, edge_id, span_count);
+    const auto add_edge = [this, bus_ptr, &edge_id](graph::VertexId from, graph::VertexId to, EdgeKind kind, int road_distance) {
+        const EdgeInfo edge_info{bus_ptr, kind == EdgeKind::RIDE ? 1 : 0, road_distance, 0.0, kind};
+        const graph::Edge<Weight> edge(from, to, ToWeight(ComputeEdgeTime(edge_info, bus_wait_time_, bus_velocity_)));
+        AddEdge(edge, bus_ptr, edge_id, edge_info.span_count_, road_distance, kind);
+    };
+    for (const auto& [begin, end] : chains) {
+        graph::VertexId prev_ride_vertex = 0;
+        for (size_t position = begin; position < end; ++position) {
+            const Stop* stop_ptr = all_stops[position];
+            if (stop_ptr->GetVertexId() == Stop::NO_VERTEX) {
+                stop_ptr->SetVertexId(AllocateVertex(stop_ptr));
+            }
+            const graph::VertexId stop_vertex = stop_ptr->GetVertexId();
+            const graph::VertexId ride_vertex = AllocateVertex(stop_ptr);
+            if (position != begin) {
+                const int road_distance = static_cast<int>(rh.ComputeDistance(all_stops[position - 1], stop_ptr));
+                add_edge(prev_ride_vertex, ride_vertex, EdgeKind::RIDE, road_distance);
+                add_edge(ride_vertex, stop_vertex, EdgeKind::ALIGHT, 0);
+            }
+            if (position + 1 != end) {
+                add_edge(stop_vertex, ride_vertex, EdgeKind::BOARD, 0);
+            }
+            prev_ride_vertex = ride_vertex;
+        }
+    }
+}
+
+std::vector<graph::VertexId> RoutingSettings::ComputeVertexOrder() const {
+    std::vector<graph::VertexId> order;
+    order.reserve(used_vertex_count_);
+    switch (vertex_order_) {
+    case VertexOrder::INPUT:
+        for (graph::VertexId vertex = 0; vertex < used_vertex_count_; ++vertex) {
+            order.push_back(vertex);
+        }
+        break;
+    case VertexOrder::HILBERT: {
+        double min_lat = std::numeric_limits<double>::infinity();
+        double max_lat = -min_lat;
+        double min_lng = min_lat;
+        double max_lng = -min_lat;
+        for (graph::VertexId vertex = 0; vertex < used_vertex_count_; ++vertex) {
+            const geo::Coordinates coordinates{vertex_id_to_stops_[vertex]->GetGeo()};
+            min_lat = std::min(min_lat, coordinates.lat);
+            max_lat = std::max(max_lat, coordinates.lat);
+            min_lng = std::min(min_lng, coordinates.lng);
+            max_lng = std::max(max_lng, coordinates.lng);
+        }
+        const double cell_count = (1u << HILBERT_ORDER) - 1;
+        const auto to_cell = [cell_count](double value, double min_value, double max_value) {
+            return max_value > min_value ? static_cast<uint32_t>((value - min_value) / (max_value - min_value) * cell_count) : 0u;
+        };
+        std::vector<std::pair<uint64_t, graph::VertexId>> indexed;
+        indexed.reserve(used_vertex_count_);
+        for (graph::VertexId vertex = 0; vertex < used_vertex_count_; ++vertex) {
+            const geo::Coordinates coordinates{vertex_id_to_stops_[vertex]->GetGeo()};
+            indexed.emplace_back(ComputeHilbertIndex(to_cell(coordinates.lng, min_lng, max_lng),
+                                                     to_cell(coordinates.lat, min_lat, max_lat)), vertex);
+        }
+        //вершины одной остановки остаются рядом в прежнем порядке
+        std::sort(indexed.begin(), indexed.end());
+        for (const auto& [index, vertex] : indexed) {
+            order.push_back(vertex);
+        }
+        break;
+    }
+    case VertexOrder::BFS: {
+        std::vector<bool> is_visited(used_vertex_count_, false);
+        for (graph::VertexId start = 0; start < used_vertex_count_; ++start) {
+            if (is_visited[start]) {
+                continue;
+            }
+            is_visited[start] = true;
+            order.push_back(start);
+            for (size_t head = order.size() - 1; head < order.size(); ++head) {
+                for (const graph::EdgeId edge_id : graph_.GetIncidentEdges(order[head])) {
+                    const graph::VertexId next = graph_.GetEdge(edge_id).to;
+                    if (!is_visited[next]) {
+                        is_visited[next] = true;
+                        order.push_back(next);
                     }
-                    ++prev_last;
-                    ++last;
                 }
             }
         }
+        break;
+    }
+    }
+    return order;
+}
+
+void RoutingSettings::ReorderVertices() {
+    const std::vector<graph::VertexId> order = ComputeVertexOrder();
+    const size_t vertex_count = graph_.GetVertexCount();
+    //вершины без остановок остаются в конце под прежними номерами
+    std::vector<graph::VertexId> new_ids(vertex_count);
+    for (graph::VertexId vertex = used_vertex_count_; vertex < vertex_count; ++vertex) {
+        new_ids[vertex] = vertex;
+    }
+    std::vector<const Stop*> vertex_id_to_stops(vertex_count, nullptr);
+    for (graph::VertexId new_id = 0; new_id < order.size(); ++new_id) {
+        new_ids[order[new_id]] = new_id;
+        vertex_id_to_stops[new_id] = vertex_id_to_stops_[order[new_id]];
+    }
+    //у остановки несколько вершин в модели с цепочками, поэтому свои вершины остановок сначала собираются
+    std::vector<graph::VertexId> stop_vertices;
+    for (graph::VertexId vertex = 0; vertex < used_vertex_count_; ++vertex) {
+        if (vertex_id_to_stops_[vertex]->GetVertexId() == vertex) {
+            stop_vertices.push_back(vertex);
+        }
+    }
+    for (const graph::VertexId vertex : stop_vertices) {
+        vertex_id_to_stops_[vertex]->SetVertexId(new_ids[vertex]);
+    }
+
+    graph::DirectedWeightedGraph<Weight> graph(vertex_count);
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const graph::Edge<Weight>& edge = graph_.GetEdge(edge_id);
+        graph.AddEdge(graph::Edge<Weight>(new_ids[edge.from], new_ids[edge.to], edge.weight));
+    }
+    graph_ = std::move(graph);
+    vertex_id_to_stops_ = std::move(vertex_id_to_stops);
+}
+
+bool RoutingSettings::IsGraphRequired() const {
+    return router_type_ != RouterType::RAPTOR;
+}
+
+void RoutingSettings::BuildRouter(const stat::RequestHandler &rh) {
+    if (route_cache_) {
+        route_cache_->Clear();
+    }
+    switch (router_type_) {
+    case RouterType::ALL_PAIRS:
+        router_ = std::make_unique<RouteEngineImpl<graph::Router<Weight>>>(graph_);
+        break;
+    case RouterType::FLAT_ALL_PAIRS:
+        router_ = std::make_unique<RouteEngineImpl<graph::FlatRouter<Weight>>>(graph_, router_threads_);
+        break;
+    case RouterType::DIJKSTRA:
+        router_ = std::make_unique<RouteEngineImpl<graph::DijkstraRouter<Weight>>>(graph_);
+        break;
+    case RouterType::ASTAR:
+        router_ = std::make_unique<RouteEngineImpl<graph::AStarRouter<Weight>>>(graph_, MakeGeoLowerBound(), router_landmarks_);
+        break;
+    case RouterType::CONTRACTION_HIERARCHY:
+        router_ = std::make_unique<RouteEngineImpl<graph::ContractionHierarchyRouter<Weight>>>(graph_);
+        break;
+    case RouterType::RAPTOR:
+        raptor_router_ = std::make_unique<RaptorRouter>(rh, bus_wait_time_, bus_velocity_);
+        break;
+    case RouterType::SPT_CACHE: {
+        //дерево больше лимита не сохранилось бы никогда, и каждый запрос считал бы его заново
+        using namespace std::literals;
+        const size_t tree_bytes = graph::SptCacheRouter<Weight>::GetTreeBytes(graph_.GetVertexCount());
+        if (router_spt_bytes_ > 0 && router_spt_bytes_ < tree_bytes) {
+            throw std::invalid_argument("router_spt_bytes should be at least "s + std::to_string(tree_bytes) + " to hold one route tree"s);
+        }
+        router_ = std::make_unique<RouteEngineImpl<graph::SptCacheRouter<Weight>>>(graph_, router_spt_trees_, router_spt_bytes_);
+        break;
+    }
+    }
+    if (IsGraphRequired()) {
+        graph_search_ = std::make_unique<graph::DijkstraRouter<Weight>>(graph_);
+        components_ = graph::ComputeComponents(graph_);
+    }
+}
+
+void RoutingSettings::AddBus(const stat::RequestHandler &rh, const Bus* bus_ptr) {
+    if (!router_ && !raptor_router_) {
+        return;
+    }
+    if (IsGraphRequired()) {
+        size_t edge_id = graph_.GetEdgeCount();
+        AddBusEdges(rh, bus_ptr, edge_id);
+    }
+    UpdateRouter(rh);
+}
+
+void RoutingSettings::RemoveBus(const stat::RequestHandler &rh, const Bus* bus_ptr) {
+    if (!router_ && !raptor_router_) {
+        return;
+    }
+    if (IsGraphRequired()) {
+        for (graph::EdgeId edge_id = 0; edge_id < edges_info_.size(); ++edge_id) {
+            if (edges_info_[edge_id].bus_ == bus_ptr) {
+                graph_.RemoveEdge(edge_id);
+            }
+        }
+        //остановки без маршрутов не находятся, как и в графе, построенном заново
+        for (const Stop* stop_ptr : bus_ptr->GetBusAndStops()) {
+            if (stop_ptr->GetStopAndBuses().empty() && stop_ptr->GetVertexId() != Stop::NO_VERTEX) {
+                vertex_id_to_stops_[stop_ptr->GetVertexId()] = nullptr;
+                stop_ptr->SetVertexId(Stop::NO_VERTEX);
+            }
+        }
     }
+    UpdateRouter(rh);
+}
+
+void RoutingSettings::UpdateRouter(const stat::RequestHandler &rh) {
+    if (route_cache_) {
+        route_cache_->Clear();
+    }
+    if (!IsGraphRequired()) {
+        BuildRouter(rh);
+        return;
+    }
+    graph_.Freeze();
+    components_ = graph::ComputeComponents(graph_);
+    switch (router_type_) {
+    case RouterType::DIJKSTRA:
+        break;
+    case RouterType::ASTAR:
+        //веса до ориентиров после изменения графа неверны, а их пересчет - K поисков по всему графу,
+        //O(K * E log V). До следующего BuildRouter оценка берется только по расстоянию: это O(E)
+        router_ = std::make_unique<RouteEngineImpl<graph::AStarRouter<Weight>>>(graph_, MakeGeoLowerBound());
+        break;
+    case RouterType::SPT_CACHE:
+        //деревья строятся по запросам, поэтому новый маршрутизатор создается сразу
+        BuildRouter(rh);
+        break;
+    case RouterType::ALL_PAIRS:
+    case RouterType::FLAT_ALL_PAIRS:
+    case RouterType::CONTRACTION_HIERARCHY:
+    case RouterType::RAPTOR:
+        //таблицы всех маршрутов и иерархию нельзя поправить локально за миллисекунды,
+        //поэтому до следующего BuildRouter маршруты ищутся по запросу. Вес маршрута тот же, что после
+        //перестроения, но из маршрутов равного веса может быть выбран другой
+        router_ = std::make_unique<RouteEngineImpl<graph::DijkstraRouter<Weight>>>(graph_);
+        router_index_.reset();
+        break;
+    }
+}
+
+graph::AStarRouter<Weight>::LowerBound RoutingSettings::MakeGeoLowerBound() const {
+    //дороги бывают короче расстояния по прямой, поэтому вес на метр берется
+    //наименьшим по всем ребрам графа: так оценка не больше веса любого маршрута.
+    //Берутся округленные веса ребер без ожидания, а целая оценка округляется вниз:
+    //тогда разность оценок соседних вершин не больше веса ребра между ними
+    std::vector<geo::Coordinates> coordinates;
+    coordinates.reserve(vertex_id_to_stops_.size());
+    for (const Stop* stop_ptr : vertex_id_to_stops_) {
+        coordinates.push_back(stop_ptr ? geo::Coordinates{stop_ptr->GetGeo()} : geo::Coordinates{0.0, 0.0});
+    }
+    double weight_per_meter = std::numeric_limits<double>::infinity();
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const graph::Edge<Weight>& edge = graph_.GetEdge(edge_id);
+        const double distance = geo::ComputeDistance(coordinates[edge.from], coordinates[edge.to]);
+        if (distance > 0.0) {
+            const Weight wait_weight = ToWeight(GetEdgeWaitTime(edges_info_[edge_id].kind_, bus_wait_time_));
+            weight_per_meter = std::min(weight_per_meter, static_cast<double>(edge.weight - wait_weight) / distance);
+        }
+    }
+    if (weight_per_meter == std::numeric_limits<double>::infinity()) {
+        weight_per_meter = 0.0;
+    }
+    return [coordinates = std::move(coordinates), weight_per_meter](graph::VertexId from, graph::VertexId to) {
+        const double bound = geo::ComputeDistance(coordinates[from], coordinates[to]) * weight_per_meter;
+        if constexpr (std::is_integral_v<Weight>) {
+            return static_cast<Weight>(std::floor(bound));
+        } else {
+            return bound;
+        }
+    };
 }
 
 double ComputeTimeForEdge (int bus_wait_time, double bus_velocity, int road_distance) {
     return bus_wait_time * 1.0 + road_distance / (bus_velocity * 1000 / 60 );
 }
 
-std::optional<RouteInform> GetRoutingItems(const graph::Router<double>& router, routing::RoutingSettings& rt, const Stop* from_ptr, const Stop* to_ptr) {
+Weight ToWeight(double time) {
+    if constexpr (std::is_integral_v<Weight>) {
+        return static_cast<Weight>(std::llround(time * WEIGHT_UNITS_PER_MINUTE));
+    } else {
+        return time;
+    }
+}
+
+double ToMinutes(Weight weight) {
+    return weight / WEIGHT_UNITS_PER_MINUTE;
+}
+
+double ComputeEdgeTime(const EdgeInfo& edge_info, int bus_wait_time, double bus_velocity) {
+    switch (edge_info.kind_) {
+    case EdgeKind::SPAN:
+        return ComputeTimeForEdge(bus_wait_time, bus_velocity, edge_info.road_distance_);
+    case EdgeKind::BOARD:
+        return bus_wait_time * 1.0;
+    case EdgeKind::RIDE:
+        return ComputeTimeForEdge(0, bus_velocity, edge_info.road_distance_);
+    case EdgeKind::ALIGHT:
+        break;
+    }
+    return 0.0;
+}
+
+int GetEdgeWaitTime(EdgeKind kind, int bus_wait_time) {
+    return kind == EdgeKind::SPAN || kind == EdgeKind::BOARD ? bus_wait_time : 0;
+}
+
+RouterType ParseRouterType(std::string_view name) {
+    using namespace std::literals;
+    if (name == "all_pairs"sv) {
+        return RouterType::ALL_PAIRS;
+    }
+    if (name == "flat_all_pairs"sv) {
+        return RouterType::FLAT_ALL_PAIRS;
+    }
+    if (name == "dijkstra"sv) {
+        return RouterType::DIJKSTRA;
+    }
+    if (name == "astar"sv) {
+        return RouterType::ASTAR;
+    }
+    if (name == "contraction_hierarchy"sv) {
+        return RouterType::CONTRACTION_HIERARCHY;
+    }
+    if (name == "raptor"sv) {
+        return RouterType::RAPTOR;
+    }
+    if (name == "spt_cache"sv) {
+        return RouterType::SPT_CACHE;
+    }
+    throw std::invalid_argument("Unknown router type"s);
+}
+
+VertexOrder ParseVertexOrder(std::string_view name) {
+    using namespace std::literals;
+    if (name == "input"sv) {
+        return VertexOrder::INPUT;
+    }
+    if (name == "hilbert"sv) {
+        return VertexOrder::HILBERT;
+    }
+    if (name == "bfs"sv) {
+        return VertexOrder::BFS;
+    }
+    throw std::invalid_argument("Unknown vertex order"s);
+}
+
+GraphModel ParseGraphModel(std::string_view name) {
+    using namespace std::literals;
+    if (name == "spans"sv) {
+        return GraphModel::SPANS;
+    }
+    if (name == "ride_chains"sv) {
+        return GraphModel::RIDE_CHAINS;
+    }
+    throw std::invalid_argument("Unknown graph model"s);
+}
+
+namespace {
+std::optional<RouteInform> BuildRoutingItems(const routing::RoutingSettings& rt, const Stop* from_ptr, const Stop* to_ptr,
+                                             bool is_profile_used, int bus_wait_time, double bus_velocity) {
     std::optional<RouteInform> result;
     std::vector<RoutingItems> res;
 
-    auto it1 = rt.stops_to_vertex_id_.find(from_ptr);
-    auto it2 = rt.stops_to_vertex_id_.find(to_ptr);
-    if (it1 == rt.stops_to_vertex_id_.end() || it2 == rt.stops_to_vertex_id_.end()) {
+    if (rt.raptor_router_) {
+        std::optional<RaptorJourney> journey = rt.raptor_router_->BuildRoute(from_ptr, to_ptr, bus_wait_time, bus_velocity);
+        if (journey) {
+            for (const auto& leg : journey->legs_) {
+                res.emplace_back(leg.board_stop_->GetStop(), bus_wait_time, leg.bus_->GetBus(), leg.span_count_, leg.time_);
+            }
+            result = RouteInform(journey->total_time_, res);
+        }
         return result;
     }
 
-    std::optional<typename graph::Router<double>::RouteInfo> route_info = router.BuildRoute(rt.stops_to_vertex_id_.at(from_ptr), rt.stops_to_vertex_id_.at(to_ptr));
+    if (!rt.router_) {
+        return result;
+    }
 
-    if (route_info) {
-        std::vector<graph::EdgeId> edges = route_info->edges;
-        double total_time = route_info->weight;
+    if (!from_ptr || !to_ptr) {
+        return result;
+    }
+    const size_t from_vertex = from_ptr->GetVertexId();
+    const size_t to_vertex = to_ptr->GetVertexId();
+    if (from_vertex == Stop::NO_VERTEX || to_vertex == Stop::NO_VERTEX) {
+        return result;
+    }
+    //остановки в разных частях сети: маршрута нет при любом профиле, поиск не нужен
+    if (!rt.components_.MayReach(from_vertex, to_vertex)) {
+        return result;
+    }
 
-        if (!edges.empty()) {
-            for (const auto& edge : edges) {
-                const graph::Edge<double> cur_edge = rt.graph_.GetEdge(edge);
-                std::string_view stop_name = rt.vertex_id_to_stops_[cur_edge.from]->GetStop();
-                std::string_view bus_name = rt.buses_to_edge_id_[edge].first->GetBus();
-                int span_count = rt.buses_to_edge_id_[edge].second;
-                double time = cur_edge.weight - rt.bus_wait_time_;
+    //веса ребер графа посчитаны для общих настроек, для своего профиля они считаются во время поиска
+    const auto compute_edge_weight = [&rt, bus_wait_time, bus_velocity](graph::EdgeId edge) {
+        return ToWeight(ComputeEdgeTime(rt.edges_info_[edge], bus_wait_time, bus_velocity));
+    };
+    std::optional<RouteEngine::RouteInfo> route_info;
+    if (!is_profile_used) {
+        route_info = rt.router_->BuildRoute(from_vertex, to_vertex);
+    } else if (rt.graph_search_) {
+        route_info = rt.graph_search_->BuildRoute(from_vertex, to_vertex, compute_edge_weight);
+    }
+
+    if (route_info) {
+        const std::vector<graph::EdgeId>& edges = route_info->edges;
+        //время маршрута складывается из точного времени ребер, а не из округленного веса
+        double total_time = 0.0;
 
-                RoutingItems item(stop_name, rt.bus_wait_time_, bus_name, span_count, time);
-                res.push_back(item);
+        res.reserve(edges.size());
+        for (const graph::EdgeId edge : edges) {
+            const EdgeInfo& edge_info = rt.edges_info_[edge];
+            const int wait_time = GetEdgeWaitTime(edge_info.kind_, bus_wait_time);
+            const double time = is_profile_used ? ComputeEdgeTime(edge_info, bus_wait_time, bus_velocity) - wait_time
+                                                : edge_info.time_;
+            total_time += wait_time + time;
+            //поездка по цепочке вершин автобуса собирается в один элемент от посадки до выхода
+            switch (edge_info.kind_) {
+            case EdgeKind::SPAN:
+            case EdgeKind::BOARD: {
+                std::string_view stop_name = rt.vertex_id_to_stops_[rt.graph_.GetEdge(edge).from]->GetStop();
+                res.emplace_back(stop_name, bus_wait_time, edge_info.bus_->GetBus(), edge_info.span_count_, time);
+                break;
+            }
+            case EdgeKind::RIDE:
+                res.back().span_count_ += edge_info.span_count_;
+                res.back().time_ += time;
+                break;
+            case EdgeKind::ALIGHT:
+                break;
             }
         }
 
@@ -118,5 +596,158 @@ std::optional<RouteInform> GetRoutingItems(const graph::Router<double>& router,
 
     return result;
 }
+
+//память записи кэша: ключ, ответ и элементы маршрута
+size_t ComputeCacheEntrySize(const std::optional<RouteInform>& route_inform) {
+    size_t bytes = sizeof(RouteCacheKey) + sizeof(std::optional<RouteInform>);
+    if (route_inform) {
+        bytes += route_inform->routing_items_.capacity() * sizeof(RoutingItems);
+    }
+    return bytes;
+}
+}// namespace
+
+std::optional<RouteInform> GetRoutingItems(const routing::RoutingSettings& rt, const Stop* from_ptr, const Stop* to_ptr,
+                                           const std::optional<RoutingProfile>& profile) {
+    const bool is_profile_used = profile
+                                 && (profile->bus_wait_time_ != rt.bus_wait_time_ || profile->bus_velocity_ != rt.bus_velocity_);
+    const int bus_wait_time = is_profile_used ? profile->bus_wait_time_ : rt.bus_wait_time_;
+    const double bus_velocity = is_profile_used ? profile->bus_velocity_ : rt.bus_velocity_;
+    if (is_profile_used && !profile->IsValid()) {
+        using namespace std::literals;
+        throw std::invalid_argument("Invalid routing profile"s);
+    }
+
+    if (!rt.route_cache_) {
+        return BuildRoutingItems(rt, from_ptr, to_ptr, is_profile_used, bus_wait_time, bus_velocity);
+    }
+    //в ключе действующие время ожидания и скорость: ответы для разных профилей не смешиваются
+    const RouteCacheKey key{from_ptr, to_ptr, bus_wait_time, bus_velocity};
+    if (std::optional<std::optional<RouteInform>> cached = rt.route_cache_->Find(key)) {
+        return std::move(*cached);
+    }
+    std::optional<RouteInform> result = BuildRoutingItems(rt, from_ptr, to_ptr, is_profile_used, bus_wait_time, bus_velocity);
+    rt.route_cache_->Insert(key, result, ComputeCacheEntrySize(result));
+    return result;
+}
+
+RouteMatrix GetRouteMatrix(const routing::RoutingSettings& rt, const std::vector<const Stop*>& sources, const std::vector<const Stop*>& targets) {
+    RouteMatrix result;
+    result.source_count_ = sources.size();
+    result.target_count_ = targets.size();
+    result.total_times_.assign(sources.size() * targets.size(), std::nullopt);
+
+    if (rt.raptor_router_) {
+        parallel::ForEachIndex(sources.size(), rt.router_threads_, [&](size_t row) {
+            if (!sources[row]) {
+                return;
+            }
+            for (size_t column = 0; column < targets.size(); ++column) {
+                if (!targets[column]) {
+                    continue;
+                }
+                if (std::optional<RaptorJourney> journey = rt.raptor_router_->BuildRoute(sources[row], targets[column])) {
+                    result.total_times_[row * targets.size() + column] = journey->total_time_;
+                }
+            }
+        });
+        return result;
+    }
+
+    if (!rt.graph_search_) {
+        return result;
+    }
+
+    //остановки вне графа пропускаем, до остальных ищем маршруты одним поиском из каждой остановки отправления
+    std::vector<graph::VertexId> target_vertices;
+    std::vector<size_t> target_columns;
+    for (size_t column = 0; column < targets.size(); ++column) {
+        if (targets[column] && targets[column]->GetVertexId() != Stop::NO_VERTEX) {
+            target_vertices.push_back(targets[column]->GetVertexId());
+            target_columns.push_back(column);
+        }
+    }
+
+    parallel::ForEachIndex(sources.size(), rt.router_threads_, [&](size_t row) {
+        if (!sources[row] || sources[row]->GetVertexId() == Stop::NO_VERTEX) {
+            return;
+        }
+        //недостижимые остановки не ищем, иначе поиск обойдет всю доступную часть сети
+        const graph::VertexId source = sources[row]->GetVertexId();
+        std::vector<graph::VertexId> reachable_vertices;
+        std::vector<size_t> reachable_columns;
+        for (size_t i = 0; i < target_vertices.size(); ++i) {
+            if (rt.components_.MayReach(source, target_vertices[i])) {
+                reachable_vertices.push_back(target_vertices[i]);
+                reachable_columns.push_back(target_columns[i]);
+            }
+        }
+        const std::vector<std::optional<Weight>> weights = rt.graph_search_->BuildWeights(source, reachable_vertices);
+        for (size_t i = 0; i < weights.size(); ++i) {
+            if (weights[i]) {
+                result.total_times_[row * targets.size() + reachable_columns[i]] = ToMinutes(*weights[i]);
+            }
+        }
+    });
+    return result;
+}
+
+std::optional<std::vector<ReachableStop>> GetIsochrone(const routing::RoutingSettings& rt, const Stop* from_ptr, double max_time) {
+    if (!rt.graph_search_ || !from_ptr || from_ptr->GetVertexId() == Stop::NO_VERTEX) {
+        return std::nullopt;
+    }
+    std::vector<ReachableStop> result;
+    const Weight max_weight = ToWeight(std::min(max_time, ToMinutes(std::numeric_limits<Weight>::max())));
+    for (const auto& [vertex_id, weight] : rt.graph_search_->BuildReachable(from_ptr->GetVertexId(), max_weight)) {
+        //вершины в автобусах пропускаем: из них выходят на остановку за то же время
+        const Stop* stop_ptr = rt.vertex_id_to_stops_[vertex_id];
+        if (stop_ptr->GetVertexId() == vertex_id) {
+            result.push_back(ReachableStop{stop_ptr, ToMinutes(weight)});
+        }
+    }
+    return result;
+}
+
+RouterStats GetRouterStats(const routing::RoutingSettings& rt) {
+    RouterStats stats;
+    if (rt.route_cache_) {
+        stats.route_cache_ = rt.route_cache_->GetStats();
+    }
+    using SptCacheEngine = RouteEngineImpl<graph::SptCacheRouter<Weight>>;
+    if (const auto* spt_router = dynamic_cast<const SptCacheEngine*>(rt.router_.get())) {
+        stats.spt_cache_ = spt_router->GetRouter().GetStats();
+    }
+    if (rt.router_type_ == RouterType::FLAT_ALL_PAIRS) {
+        stats.min_plus_kernel_ = graph::GetMinPlusKernelName();
+    }
+    //после изменения графа до следующего BuildRouter ищет DijkstraRouter, и сокращений нет
+    using HierarchyEngine = RouteEngineImpl<graph::ContractionHierarchyRouter<Weight>>;
+    if (const auto* hierarchy_router = dynamic_cast<const HierarchyEngine*>(rt.router_.get())) {
+        stats.shortcut_count_ = hierarchy_router->GetRouter().GetShortcutCount();
+    }
+    using AStarEngine = RouteEngineImpl<graph::AStarRouter<Weight>>;
+    if (const auto* astar_router = dynamic_cast<const AStarEngine*>(rt.router_.get())) {
+        stats.landmark_count_ = astar_router->GetRouter().GetLandmarks().size();
+    }
+    return stats;
+}
+
+const Bus* AddBus(head::TransportCatalogue& tc, routing::RoutingSettings& rt, std::string_view name, bool is_ring,
+                  std::vector<const Stop*> stops) {
+    const Bus* bus_ptr = tc.InsertBus(name, is_ring, std::move(stops));
+    rt.AddBus(stat::RequestHandler(tc), bus_ptr);
+    return bus_ptr;
+}
+
+bool RemoveBus(head::TransportCatalogue& tc, routing::RoutingSettings& rt, std::string_view name) {
+    const stat::RequestHandler rh(tc);
+    const Bus* bus_ptr = rh.FindBus(name);
+    if (!bus_ptr) {
+        return false;
+    }
+    tc.RemoveBus(bus_ptr);
+    rt.RemoveBus(rh, bus_ptr);
+    return true;
+}
 }// namespace routing
 }// namespace catalogue
\ No newline at end of file
@@ -1,13 +1,28 @@
 #pragma once
 
+#include "astar_router.h"
+#include "contraction_hierarchy.h"
+#include "dijkstra_router.h"
 #include "domain.h"
+#include "flat_router.h"
 #include "graph.h"
+#include "graph_components.h"
+#include "lru_cache.h"
+#include "parallel.h"
+#include "raptor_router.h"
 #include "request_handler.h"
 #include "router.h"
+#include "spt_cache_router.h"
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
 #include <string_view>
-#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace catalogue {
@@ -15,20 +30,87 @@ namespace routing {
 using Stop = domain::Stop;
 using Bus = domain::Bus;
 
-class RoutingSettings {
+//вес ребер и маршрутов графа: время в сотых долях минуты. Целые веса вдвое короче double
+//в таблицах маршрутов и сравниваются без ветвлений; для весов в минутах достаточно указать double
+using Weight = int32_t;
+constexpr double WEIGHT_UNITS_PER_MINUTE = std::is_integral_v<Weight> ? 100.0 : 1.0;
+
+enum class RouterType {
+    ALL_PAIRS,                                                                      //предварительный расчет всех маршрутов (Флойд-Уоршелл)
+    FLAT_ALL_PAIRS,                                                                 //то же в плоской таблице с блочной релаксацией
+    DIJKSTRA,                                                                       //поиск маршрута по запросу (Дейкстра)
+    ASTAR,                                                                          //поиск по запросу с оценкой по координатам и ориентирам (A*, ALT)
+    CONTRACTION_HIERARCHY,                                                          //двунаправленный поиск по иерархии сокращений
+    RAPTOR,                                                                         //поиск по раундам по остановкам автобусов, без графа
+    SPT_CACHE,                                                                      //поиск по запросу с запоминанием деревьев маршрутов из частых начал
+};
+
+enum class GraphModel {
+    SPANS,                                                                          //ребро на каждую пару остановок маршрута, вершина на остановку
+    RIDE_CHAINS,                                                                    //вершины ожидания на остановках и цепочки вершин в автобусах
+};
+
+//порядок номеров вершин графа: соседние по порядку вершины лежат рядом в массивах маршрутизаторов
+enum class VertexOrder {
+    INPUT,                                                                          //в порядке обхода маршрутов по названиям
+    HILBERT,                                                                        //вдоль кривой Гильберта по координатам остановок
+    BFS,                                                                            //в порядке обхода графа в ширину
+};
+
+//вид ребра графа
+enum class EdgeKind {
+    SPAN,                                                                           //ожидание и поездка через несколько остановок
+    BOARD,                                                                          //посадка в автобус: ожидание
+    RIDE,                                                                           //поездка до следующей остановки маршрута
+    ALIGHT,                                                                         //выход из автобуса
+};
+
+//интерфейс маршрутизатора по графу, позволяет выбирать алгоритм при запуске
+class RouteEngine {
 public:
-    graph::Edge<double> BuildEdge(const Stop* from, const Stop* to, size_t& vertex_id, double road_distance);
+    using RouteInfo = graph::Router<Weight>::RouteInfo;
 
-    void AddEdge(const graph::Edge<double> &edge, const Bus *ptr, size_t &edge_id, int span_count);
+    virtual ~RouteEngine() = default;
+    virtual std::optional<RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const = 0;
+};
 
-    void BuildGraph(const stat::RequestHandler &rh);
+template <typename Router>
+class RouteEngineImpl final : public RouteEngine {
+public:
+    template <typename... Args>
+    explicit RouteEngineImpl(const graph::DirectedWeightedGraph<Weight>& graph, Args&&... args)
+    : router_(graph, std::forward<Args>(args)...) {
+    }
 
-    int bus_wait_time_ = 0;                                                         //время ожидания автобуса
-    double bus_velocity_ = 0.0;                                                     //скорость автобуса в км/ч
-    graph::DirectedWeightedGraph<double> graph_;                                    //граф
-    std::unordered_map<const Stop*, size_t> stops_to_vertex_id_;                    //словарь указатель на остановку - номер вершины графа
-    std::unordered_map<size_t, const Stop*> vertex_id_to_stops_;                    //словарь номер вершины графа - указатель на остановку
-    std::unordered_map<size_t, std::pair<const Bus*, int>> buses_to_edge_id_;       //словарь номер ребра графа - указатель на маршрут и кол-во остановок на ребре
+    std::optional<RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const override {
+        return router_.BuildRoute(from, to);
+    }
+
+    const Router& GetRouter() const {
+        return router_;
+    }
+
+private:
+    Router router_;
+};
+
+//сведения о ребре графа для ответа на запрос маршрута
+struct EdgeInfo {
+    const Bus* bus_ = nullptr;
+    int span_count_ = 0;                                                            //кол-во остановок на ребре
+    int road_distance_ = 0;                                                         //расстояние по дорогам
+    double time_ = 0.0;                                                             //время в пути без ожидания
+    EdgeKind kind_ = EdgeKind::SPAN;
+};
+
+//время ожидания и скорость автобуса для отдельного запроса вместо общих настроек
+struct RoutingProfile {
+    bool IsValid() const {
+        return bus_wait_time_ >= 0 && bus_velocity_ > 0.0;
+    }
+
+    int bus_wait_time_ = 0;
+    double bus_velocity_ = 0.0;
 };
 
 class RoutingItems {
@@ -57,8 +139,150 @@ struct RouteInform {
     std::vector<RoutingItems> routing_items_;
 };
 
+//запрос маршрута с действующими временем ожидания и скоростью
+struct RouteCacheKey {
+    const Stop* from_ = nullptr;
+    const Stop* to_ = nullptr;
+    int bus_wait_time_ = 0;
+    double bus_velocity_ = 0.0;
+
+    bool operator==(const RouteCacheKey& other) const {
+        return from_ == other.from_ && to_ == other.to_
+               && bus_wait_time_ == other.bus_wait_time_ && bus_velocity_ == other.bus_velocity_;
+    }
+};
+
+struct RouteCacheKeyHasher {
+    std::size_t operator()(const RouteCacheKey& key) const {
+        uint64_t hash = (size_t)(key.from_) * 37 + (size_t)(key.to_) * 37 * 37;
+        hash = hash * 37 + static_cast<uint64_t>(key.bus_wait_time_);
+        hash = hash * 37 + std::hash<double>{}(key.bus_velocity_);
+        return static_cast<size_t>(hash);
+    }
+};
+
+//готовые ответы на запросы маршрутов, nullopt - маршрут не найден
+using RouteCache = cache::LruCache<RouteCacheKey, std::optional<RouteInform>, RouteCacheKeyHasher>;
+
+class MappedFile;
+
+class RoutingSettings {
+public:
+    graph::VertexId AllocateVertex(const Stop* stop_ptr);                            //добавляет вершину графа для остановки
+
+    graph::Edge<Weight> BuildEdge(const Stop* from, const Stop* to, double road_distance);
+
+    void AddEdge(const graph::Edge<Weight> &edge, const Bus *ptr, size_t &edge_id, int span_count, int road_distance,
+                 EdgeKind kind = EdgeKind::SPAN);
+
+    void ResetGraph(const stat::RequestHandler &rh, size_t vertex_count);          //очищает граф и номера вершин остановок
+
+    void BuildGraph(const stat::RequestHandler &rh);
+
+    void AddBusEdges(const stat::RequestHandler &rh, const Bus* bus_ptr, size_t& edge_id);   //добавляет в граф ребра маршрута
+
+    void AddBusSpans(const stat::RequestHandler &rh, const Bus* bus_ptr, size_t& edge_id);   //ребра между всеми парами остановок маршрута
+
+    void AddBusRideChains(const stat::RequestHandler &rh, const Bus* bus_ptr, size_t& edge_id);   //цепочки поездки, посадки и выходы
+
+    std::vector<graph::VertexId> ComputeVertexOrder() const;                        //прежние номера вершин в порядке vertex_order_
+
+    void ReorderVertices();                                                         //перенумеровывает вершины графа, номера ребер не меняются
+
+    bool IsGraphRequired() const;                                                   //нужен ли выбранному маршрутизатору граф
+
+    void BuildRouter(const stat::RequestHandler &rh);                               //создает маршрутизатор выбранного типа
+
+    void AddBus(const stat::RequestHandler &rh, const Bus* bus_ptr);               //добавляет ребра нового маршрута в построенный граф
+
+    void RemoveBus(const stat::RequestHandler &rh, const Bus* bus_ptr);            //убирает из графа ребра маршрута, удаленного из справочника
+
+    void UpdateRouter(const stat::RequestHandler &rh);                              //обновляет маршрутизатор после изменения графа
+
+    graph::AStarRouter<Weight>::LowerBound MakeGeoLowerBound() const;              //оценка времени в пути по расстоянию между остановками
+
+    int bus_wait_time_ = 0;                                                         //время ожидания автобуса
+    double bus_velocity_ = 0.0;                                                     //скорость автобуса в км/ч
+    RouterType router_type_ = RouterType::ALL_PAIRS;                                //алгоритм поиска маршрута
+    GraphModel graph_model_ = GraphModel::SPANS;                                    //способ построения графа
+    VertexOrder vertex_order_ = VertexOrder::INPUT;                                 //порядок номеров вершин графа
+    size_t router_threads_ = 1;                                                     //потоков для предварительного расчета и матриц маршрутов (0 - все ядра)
+    size_t router_landmarks_ = 8;                                                   //ориентиров для оценок поиска A*
+    size_t router_spt_trees_ = 64;                                                  //деревьев маршрутов в памяти маршрутизатора spt_cache
+    size_t router_spt_bytes_ = 0;                                                   //памяти под деревья маршрутов в байтах (0 - без ограничения)
+    size_t route_cache_entries_ = 0;                                                //ответов в кэше маршрутов (0 и без лимита памяти - кэш выключен)
+    size_t route_cache_bytes_ = 0;                                                  //памяти под кэш маршрутов в байтах (0 - без ограничения)
+    std::string router_index_file_;                                                 //файл с сохраненным графом и таблицами маршрутизатора
+    graph::DirectedWeightedGraph<Weight> graph_;                                    //граф
+    std::vector<const Stop*> vertex_id_to_stops_;                                   //остановки по номерам вершин графа (и вершин в автобусах)
+    size_t used_vertex_count_ = 0;                                                  //вершин графа, уже сопоставленных остановкам
+    std::vector<EdgeInfo> edges_info_;                                              //маршрут, кол-во остановок и время в пути по номерам ребер графа
+    std::shared_ptr<const MappedFile> router_index_;                                //отображенный в память файл, из которого загружен маршрутизатор
+    std::unique_ptr<RouteEngine> router_;                                           //маршрутизатор по графу
+    std::unique_ptr<RaptorRouter> raptor_router_;                                   //маршрутизатор по раундам
+    std::unique_ptr<graph::DijkstraRouter<Weight>> graph_search_;                   //поиск по графу для матриц маршрутов, изохрон и запросов со своим профилем
+    graph::GraphComponents components_;                                             //компоненты связности графа для отказа без поиска
+    std::unique_ptr<RouteCache> route_cache_;                                       //ответы на частые запросы маршрутов, очищается при изменении графа
+};
+
+//матрица времени в пути между остановками, nullopt - маршрут не найден
+struct RouteMatrix {
+    size_t source_count_ = 0;
+    size_t target_count_ = 0;
+    std::vector<std::optional<double>> total_times_;                                //время из sources[i] в targets[j] в ячейке i * target_count_ + j
+};
+
+//остановка, до которой можно доехать за отведенное время
+struct ReachableStop {
+    const Stop* stop_ = nullptr;
+    double time_ = 0.0;                                                             //время в пути до остановки
+};
+
+//счетчики кэшей и сведения о предварительном расчете маршрутизатора; nullopt - кэш выключен
+//или у маршрутизатора нет такого расчета
+struct RouterStats {
+    std::optional<cache::CacheStats> route_cache_;                                  //кэш ответов на запросы маршрутов
+    std::optional<cache::CacheStats> spt_cache_;                                    //деревья маршрутов маршрутизатора spt_cache
+    std::optional<std::string> min_plus_kernel_;                                    //реализация релаксации таблицы flat_all_pairs
+    std::optional<size_t> shortcut_count_;                                          //сокращения иерархии contraction_hierarchy
+    std::optional<size_t> landmark_count_;                                          //ориентиры оценок A*
+};
+
 double ComputeTimeForEdge(int bus_wait_time, double bus_velocity, int road_distance);
 
-std::optional<RouteInform> GetRoutingItems(const graph::Router<double>& router, routing::RoutingSettings& rt, const Stop* from_ptr, const Stop* to_ptr);
+Weight ToWeight(double time);                                                       //переводит минуты в вес графа с округлением
+
+double ToMinutes(Weight weight);                                                    //переводит вес графа в минуты без потерь
+
+double ComputeEdgeTime(const EdgeInfo& edge_info, int bus_wait_time, double bus_velocity);   //время по ребру графа в минутах по его виду
+
+int GetEdgeWaitTime(EdgeKind kind, int bus_wait_time);                              //ожидание автобуса, входящее в вес ребра
+
+RouterType ParseRouterType(std::string_view name);                                 //возвращает тип маршрутизатора по названию из настроек
+
+GraphModel ParseGraphModel(std::string_view name);                                 //возвращает способ построения графа по названию из настроек
+
+VertexOrder ParseVertexOrder(std::string_view name);                               //возвращает порядок вершин графа по названию из настроек
+
+//profile заменяет время ожидания и скорость из rt; веса ребер тогда считаются во время поиска по расстояниям
+std::optional<RouteInform> GetRoutingItems(const routing::RoutingSettings& rt, const Stop* from_ptr, const Stop* to_ptr,
+                                           const std::optional<RoutingProfile>& profile = std::nullopt);
+
+RouteMatrix GetRouteMatrix(const routing::RoutingSettings& rt, const std::vector<const Stop*>& sources, const std::vector<const Stop*>& targets);
+
+//остановки, достижимые из from_ptr не дольше max_time, в порядке возрастания времени; nullopt - остановка не найдена
+//нужен граф, поэтому с router_type raptor запрос изохроны отклоняется до вызова
+std::optional<std::vector<ReachableStop>> GetIsochrone(const routing::RoutingSettings& rt, const Stop* from_ptr, double max_time);
+
+RouterStats GetRouterStats(const routing::RoutingSettings& rt);
+
+//добавляет маршрут в заполненный справочник и в построенный граф без перестроения остальных ребер;
+//расстояния между остановками маршрута должны быть уже добавлены в справочник.
+//Вызывается для update_requests из входного файла
+const Bus* AddBus(head::TransportCatalogue& tc, routing::RoutingSettings& rt, std::string_view name, bool is_ring,
+                  std::vector<const Stop*> stops);
+
+//удаляет маршрут из справочника и его ребра из графа; false - маршрут не найден
+bool RemoveBus(head::TransportCatalogue& tc, routing::RoutingSettings& rt, std::string_view name);
 }// namespace routing
 }// namespace catalogue
\ No newline at end of file